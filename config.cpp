@@ -0,0 +1,615 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <sstream>
+#include <deque>
+#include <algorithm>
+
+#include "config.h"
+
+const char* BENCH_FILE = "bench.txt";
+const char* TEXTURE_BENCH_FILE = "texture_bench.txt";
+const char* READBACK_BENCH_FILE = "readback_bench.txt";
+const char* FILL_RATE_BENCH_FILE = "fill_rate_bench.txt";
+const char* SCENE_BENCH_FILE = "scene_bench.txt";
+const char* CALL_LIST_BENCH_FILE = "call_list_bench.txt";
+const char* STREAMING_BENCH_FILE = "streaming_bench.txt";
+const char* PROCEDURAL_BENCH_FILE = "procedural_bench.txt";
+const char* GPU_CULLING_BENCH_FILE = "gpu_culling_bench.txt";
+const char* MULTISAMPLE_BENCH_FILE = "multisample_bench.txt";
+const char* LIGHTING_BENCH_FILE = "lighting_bench.txt";
+const char* THREAD_BENCH_FILE = "thread_bench.txt";
+const char* VALIDATION_BENCH_FILE = "validation_bench.txt";
+const char* CAPTURE_FILE = "capture.raw";
+
+////////////////////////////////////////////////////////////////////////
+void print_config(const RenderingConfig& in_rendering_config, std::ostream& out_stream)
+{
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    print_config_method(in_rendering_config, out_stream);
+    out_stream << " - ('h') Call list build .......... " << call_list_build_name(in_rendering_config.call_list_build) << std::endl;
+    out_stream << " - ('s') Triangles strip mode ..... " << in_rendering_config.rendering_options.test(TRIANGLE_STRIP) << std::endl;
+    out_stream << " - ('c') Colored model ............ " << in_rendering_config.rendering_options.test(COLOR) << std::endl;
+    out_stream << " - ('t') Textured model ........... " << in_rendering_config.rendering_options.test(TEXTURE) << std::endl;
+    out_stream << " - ('m') Smooth shading ........... " << in_rendering_config.rendering_options.test(SMOOTH_SHADING) << std::endl;
+    out_stream << " - ('p') Back face painting ....... " << in_rendering_config.rendering_options.test(BACK_FACE_PAINTING) << std::endl;
+    out_stream << " - ('w') Wireframe model .......... " << in_rendering_config.rendering_options.test(WIREFRAME) << std::endl;
+    out_stream << " - ('z') Texture size ............. " << in_rendering_config.texture_size << std::endl;
+    out_stream << " - ('x') Texture format ........... " << texture_format_name(in_rendering_config.texture_format) << std::endl;
+    out_stream << " - ('f') Texture filter ........... " << texture_filter_name(in_rendering_config.texture_filter) << std::endl;
+    out_stream << " - ('r') Readback mode ............ " << readback_mode_name(in_rendering_config.readback_mode) << std::endl;
+    out_stream << " - ('e') Readback format .......... " << readback_format_name(in_rendering_config.readback_format) << std::endl;
+    out_stream << " - ('g') Capture to " << CAPTURE_FILE << " ...... " << in_rendering_config.rendering_options.test(CAPTURE) << std::endl;
+    out_stream << " - ('n') Offscreen framebuffer .... ";
+    if (in_rendering_config.framebuffer_width && in_rendering_config.framebuffer_height)
+        out_stream << in_rendering_config.framebuffer_width << "x" << in_rendering_config.framebuffer_height << std::endl;
+    else
+        out_stream << "None (window)" << std::endl;
+    out_stream << " - ('F8') MSAA samples ............ " << in_rendering_config.nb_samples << std::endl;
+    out_stream << " - ('F9') Depth format ............ " << depth_format_name(in_rendering_config.depth_format) << std::endl;
+    out_stream << " - ('o') Overdraw passes .......... " << in_rendering_config.nb_overdraw_passes << std::endl;
+    out_stream << " - ('l') Full screen overdraw ..... " << in_rendering_config.rendering_options.test(FULL_SCREEN_OVERDRAW) << std::endl;
+    out_stream << " - ('k') Chunked VBO upload ....... " << in_rendering_config.rendering_options.test(CHUNKED_UPLOAD) << std::endl;
+    out_stream << " - ('d') Scene objects ............ " << in_rendering_config.nb_scene_objects << std::endl;
+    out_stream << " - ('u') State sorted scene ....... " << in_rendering_config.rendering_options.test(SORTED_SCENE) << std::endl;
+    out_stream << " - ('F10') Lights ................. " << in_rendering_config.nb_lights << std::endl;
+    out_stream << " - ('F11') Light type ............. " << light_type_name(in_rendering_config.light_type) << std::endl;
+    out_stream << " - ('F12') Local viewer ........... " << in_rendering_config.rendering_options.test(LOCAL_VIEWER) << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_display_config(const DisplayConfig& in_display_config, std::ostream& out_stream)
+{
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    out_stream << " - ('v') Swap interval ............ " << swap_control_name(in_display_config.swap_control) << std::endl;
+    out_stream << " - ('y') glFinish latency ......... " << in_display_config.latency_measure << std::endl;
+    out_stream << " - ('j') Timeline trace ........... " << in_display_config.trace << std::endl;
+    out_stream << " - ('i') Camera ................... " << camera_mode_name(in_display_config.camera_mode) << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_config_method(const RenderingConfig& in_rendering_config, std::ostream& out_stream)
+{
+    out_stream << " - ('F1..F7') Rendering method .... ";
+    if (in_rendering_config.rendering_method == IMMEDIATE)
+        out_stream << "Immediate" << std::endl;
+    else if (in_rendering_config.rendering_method == CALL_LIST)
+        out_stream << "Call list" << std::endl;
+    else if (in_rendering_config.rendering_method == STATIC_VBO)
+        out_stream << "Static VBO" << std::endl;
+    else if (in_rendering_config.rendering_method == DYNAMIC_VBO)
+        out_stream << "Dynamic VBO" << std::endl;
+    else if (in_rendering_config.rendering_method == STREAMING_VBO)
+        out_stream << "Streaming VBO" << std::endl;
+    else if (in_rendering_config.rendering_method == PROCEDURAL)
+        out_stream << "Procedural" << std::endl;
+    else if (in_rendering_config.rendering_method == GPU_CULLED)
+        out_stream << "GPU culled VBO" << std::endl;
+    else
+        out_stream << "Not yet implemented" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_bench_config(const BenchConfig& in_bench_config, std::ostream& out_stream)
+{
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    out_stream << " - ('a') Bench type ............... ";
+    if (in_bench_config.bench_type == RENDERING_BENCH)
+        out_stream << "Rendering";
+    else if (in_bench_config.bench_type == TEXTURE_UPLOAD_BENCH)
+        out_stream << "Texture upload";
+    else if (in_bench_config.bench_type == READBACK_BENCH)
+        out_stream << "Readback";
+    else if (in_bench_config.bench_type == FILL_RATE_BENCH)
+        out_stream << "Fill rate";
+    else if (in_bench_config.bench_type == SCENE_BENCH)
+        out_stream << "Scene";
+    else if (in_bench_config.bench_type == CALL_LIST_BENCH)
+        out_stream << "Call list";
+    else if (in_bench_config.bench_type == STREAMING_BENCH)
+        out_stream << "Streaming";
+    else if (in_bench_config.bench_type == PROCEDURAL_BENCH)
+        out_stream << "Procedural";
+    else if (in_bench_config.bench_type == GPU_CULLING_BENCH)
+        out_stream << "GPU culling";
+    else if (in_bench_config.bench_type == MULTISAMPLE_BENCH)
+        out_stream << "Multisample";
+    else if (in_bench_config.bench_type == LIGHTING_BENCH)
+        out_stream << "Lighting";
+    else if (in_bench_config.bench_type == THREAD_SCALING_BENCH)
+        out_stream << "Thread scaling";
+    else if (in_bench_config.bench_type == VALIDATION_BENCH)
+        out_stream << "Validation";
+    else
+        out_stream << "Not yet implemented";
+    out_stream << " (" << bench_file_name(in_bench_config.bench_type) << ")" << std::endl;
+    out_stream << " - Frames per config .............. " << in_bench_config.min_frames << " to " << in_bench_config.max_frames << std::endl;
+    out_stream << " - Median precision target ........ " << in_bench_config.target_precision * 100.0 << " %" << std::endl;
+    out_stream << " - Time budget .................... " << in_bench_config.time_budget << " s" << std::endl;
+    out_stream << " - Resume from the report ......... " << in_bench_config.resume << std::endl;
+    out_stream << " - Shard .......................... " << in_bench_config.shard_id << "/" << in_bench_config.nb_shards
+               << " (" << bench_report_name(in_bench_config) << ")" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* bench_file_name(BenchType in_bench_type)
+{
+    if (in_bench_type == TEXTURE_UPLOAD_BENCH)
+        return TEXTURE_BENCH_FILE;
+    else if (in_bench_type == READBACK_BENCH)
+        return READBACK_BENCH_FILE;
+    else if (in_bench_type == FILL_RATE_BENCH)
+        return FILL_RATE_BENCH_FILE;
+    else if (in_bench_type == SCENE_BENCH)
+        return SCENE_BENCH_FILE;
+    else if (in_bench_type == CALL_LIST_BENCH)
+        return CALL_LIST_BENCH_FILE;
+    else if (in_bench_type == STREAMING_BENCH)
+        return STREAMING_BENCH_FILE;
+    else if (in_bench_type == PROCEDURAL_BENCH)
+        return PROCEDURAL_BENCH_FILE;
+    else if (in_bench_type == GPU_CULLING_BENCH)
+        return GPU_CULLING_BENCH_FILE;
+    else if (in_bench_type == MULTISAMPLE_BENCH)
+        return MULTISAMPLE_BENCH_FILE;
+    else if (in_bench_type == LIGHTING_BENCH)
+        return LIGHTING_BENCH_FILE;
+    else if (in_bench_type == THREAD_SCALING_BENCH)
+        return THREAD_BENCH_FILE;
+    else if (in_bench_type == VALIDATION_BENCH)
+        return VALIDATION_BENCH_FILE;
+    return BENCH_FILE;
+}
+
+////////////////////////////////////////////////////////////////////////
+std::string bench_report_name(const BenchConfig& in_bench_config)
+{
+    // Each shard has its own report, bench.txt becomes bench.2of4.txt
+    const std::string file_name = bench_file_name(in_bench_config.bench_type);
+    if (in_bench_config.nb_shards <= 1)
+    {
+        return file_name;
+    }
+    std::ostringstream shard_stream;
+    shard_stream << "." << in_bench_config.shard_id << "of" << in_bench_config.nb_shards;
+    const size_t extension_position = file_name.rfind('.');
+    return file_name.substr(0, extension_position) + shard_stream.str() + file_name.substr(extension_position);
+}
+
+////////////////////////////////////////////////////////////////////////
+bool bench_type_from_file_name(const std::string& in_file_name, BenchType& out_bench_type)
+{
+    for (unsigned int bench_type = RENDERING_BENCH; bench_type < NB_BENCH_TYPE; ++bench_type)
+    {
+        if (in_file_name == bench_file_name(static_cast<BenchType>(bench_type)))
+        {
+            out_bench_type = static_cast<BenchType>(bench_type);
+            return true;
+        }
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////
+bool is_one_shot_bench(BenchType in_bench_type)
+{
+    // Run out of the main loop, without a config matrix to checkpoint
+    return in_bench_type == TEXTURE_UPLOAD_BENCH || in_bench_type == THREAD_SCALING_BENCH || in_bench_type == VALIDATION_BENCH;
+}
+
+////////////////////////////////////////////////////////////////////////
+std::string rendering_config_key(const RenderingConfig& in_rendering_config)
+{
+    // Every field, in the order of the structure
+    std::ostringstream key_stream;
+    key_stream << in_rendering_config.rendering_method << " " << in_rendering_config.nb_triangles << " " << in_rendering_config.call_list_build << " "
+               << in_rendering_config.rendering_options.to_ulong() << " " << in_rendering_config.texture_size << " "
+               << in_rendering_config.texture_format << " " << in_rendering_config.texture_filter << " "
+               << in_rendering_config.readback_mode << " " << in_rendering_config.readback_format << " "
+               << in_rendering_config.framebuffer_width << " " << in_rendering_config.framebuffer_height << " "
+               << in_rendering_config.nb_overdraw_passes << " " << in_rendering_config.nb_samples << " " << in_rendering_config.depth_format << " "
+               << in_rendering_config.nb_lights << " " << in_rendering_config.light_type << " " << in_rendering_config.nb_scene_objects;
+    return key_stream.str();
+}
+
+////////////////////////////////////////////////////////////////////////
+bool parse_rendering_config_key(const std::string& in_key, RenderingConfig& out_rendering_config)
+{
+    std::istringstream key_stream(in_key);
+    unsigned int rendering_method = 0, call_list_build = 0, texture_format = 0, texture_filter = 0;
+    unsigned int readback_mode = 0, readback_format = 0, depth_format = 0, light_type = 0;
+    unsigned long rendering_options = 0;
+    key_stream >> rendering_method >> out_rendering_config.nb_triangles >> call_list_build >> rendering_options
+               >> out_rendering_config.texture_size >> texture_format >> texture_filter >> readback_mode >> readback_format
+               >> out_rendering_config.framebuffer_width >> out_rendering_config.framebuffer_height
+               >> out_rendering_config.nb_overdraw_passes >> out_rendering_config.nb_samples >> depth_format
+               >> out_rendering_config.nb_lights >> light_type >> out_rendering_config.nb_scene_objects;
+    if (key_stream.fail()
+        || rendering_method >= NB_RENDERING_METHOD || call_list_build >= NB_CALL_LIST_BUILD || texture_format >= NB_TEXTURE_FORMAT
+        || texture_filter >= NB_TEXTURE_FILTER || readback_mode >= NB_READBACK_MODE || readback_format >= NB_READBACK_FORMAT
+        || depth_format >= NB_DEPTH_FORMAT || light_type >= NB_LIGHT_TYPE || out_rendering_config.nb_scene_objects == 0)
+    {
+        return false;
+    }
+    out_rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+    out_rendering_config.call_list_build = static_cast<CallListBuild>(call_list_build);
+    out_rendering_config.rendering_options = rendering_options;
+    out_rendering_config.texture_format = static_cast<TextureFormat>(texture_format);
+    out_rendering_config.texture_filter = static_cast<TextureFilter>(texture_filter);
+    out_rendering_config.readback_mode = static_cast<ReadbackMode>(readback_mode);
+    out_rendering_config.readback_format = static_cast<ReadbackFormat>(readback_format);
+    out_rendering_config.depth_format = static_cast<DepthFormat>(depth_format);
+    out_rendering_config.light_type = static_cast<LightType>(light_type);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* texture_format_name(TextureFormat in_texture_format)
+{
+    if (in_texture_format == TEXTURE_RGBA8)
+        return "RGBA8";
+    else if (in_texture_format == TEXTURE_COMPRESSED)
+        return "Compressed";
+    else if (in_texture_format == TEXTURE_FLOAT)
+        return "Float";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* texture_filter_name(TextureFilter in_texture_filter)
+{
+    if (in_texture_filter == TEXTURE_NEAREST)
+        return "Nearest";
+    else if (in_texture_filter == TEXTURE_TRILINEAR)
+        return "Trilinear";
+    else if (in_texture_filter == TEXTURE_ANISOTROPIC)
+        return "Anisotropic";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* texture_upload_method_name(TextureUploadMethod in_upload_method)
+{
+    if (in_upload_method == TEX_IMAGE_UPLOAD)
+        return "glTexImage2D";
+    else if (in_upload_method == TEX_SUB_IMAGE_UPLOAD)
+        return "glTexSubImage2D";
+    else if (in_upload_method == PBO_UPLOAD)
+        return "PBO";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* swap_control_name(SwapControl in_swap_control)
+{
+    if (in_swap_control == DRIVER_SWAP_INTERVAL)
+        return "Driver default";
+    else if (in_swap_control == NO_VSYNC)
+        return "0 (no vsync)";
+    else if (in_swap_control == VSYNC)
+        return "1 (vsync)";
+    else if (in_swap_control == ADAPTIVE_VSYNC)
+        return "-1 (adaptive vsync)";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* camera_mode_name(CameraMode in_camera_mode)
+{
+    if (in_camera_mode == TIMED_CAMERA)
+        return "Timed rotation";
+    else if (in_camera_mode == FIXED_STEP_CAMERA)
+        return "Fixed step";
+    else if (in_camera_mode == ORBIT_PATH_CAMERA)
+        return "Orbit path";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* call_list_build_name(CallListBuild in_call_list_build)
+{
+    if (in_call_list_build == REPLAY_CALL_LIST)
+        return "Immediate replay";
+    else if (in_call_list_build == VERTEX_ARRAY_CALL_LIST)
+        return "Vertex arrays";
+    else if (in_call_list_build == STRIP_CALL_LISTS)
+        return "Vertex arrays, one list per strip";
+    else if (in_call_list_build == COMPILE_AND_EXECUTE_CALL_LIST)
+        return "Vertex arrays, compile and execute";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* readback_mode_name(ReadbackMode in_readback_mode)
+{
+    if (in_readback_mode == NO_READBACK)
+        return "None";
+    else if (in_readback_mode == SYNC_READBACK)
+        return "Sync glReadPixels";
+    else if (in_readback_mode == PBO_READBACK)
+        return "PBO ring";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* readback_format_name(ReadbackFormat in_readback_format)
+{
+    if (in_readback_format == READBACK_RGBA8)
+        return "RGBA8";
+    else if (in_readback_format == READBACK_BGRA)
+        return "BGRA";
+    else if (in_readback_format == READBACK_DEPTH)
+        return "Depth";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* depth_format_name(DepthFormat in_depth_format)
+{
+    if (in_depth_format == DEPTH_16)
+        return "16 bits";
+    else if (in_depth_format == DEPTH_24)
+        return "24 bits";
+    else if (in_depth_format == DEPTH_32F)
+        return "32 bits float";
+    return "Not yet implemented";
+}
+
+////////////////////////////////////////////////////////////////////////
+const char* light_type_name(LightType in_light_type)
+{
+    if (in_light_type == DIRECTIONAL_LIGHT)
+        return "Directional";
+    else if (in_light_type == POINT_LIGHT)
+        return "Point";
+    else if (in_light_type == SPOT_LIGHT)
+        return "Spot";
+    return "Not yet implemented";
+}
+
+//////////////////////////////////////////////////////////////////////////////
+unsigned int frame_nb_triangles(const RenderingConfig& in_rendering_config)
+{
+    // Full screen overdraw layers are only 2 triangles each, the mesh is drawn once
+    if (in_rendering_config.rendering_options.test(FULL_SCREEN_OVERDRAW))
+    {
+        return in_rendering_config.nb_triangles;
+    }
+    return in_rendering_config.nb_triangles * in_rendering_config.nb_overdraw_passes;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int nb_mesh_triangles(const RenderingConfig& in_rendering_config)
+{
+    return std::max(2U, in_rendering_config.nb_triangles / in_rendering_config.nb_scene_objects);
+}
+
+////////////////////////////////////////////////////////////////////////
+bool model_kept_in_memory(const RenderingConfig& in_rendering_config)
+{
+    // Streamed chunks are generated while drawing, procedural vertices by the GPU
+    return in_rendering_config.rendering_method != STREAMING_VBO && in_rendering_config.rendering_method != PROCEDURAL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        for (unsigned int rendering_options = 0 ; rendering_options != (1U << NB_BENCH_RENDERING_OPTION); ++rendering_options)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.rendering_method = static_cast<RenderingMethod> (rendering_method);
+            rendering_config.rendering_options = rendering_options;
+            rendering_config.rendering_options.set(LOCAL_VIEWER, in_base_rendering_config.rendering_options.test(LOCAL_VIEWER));   // part of the lighting
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_readback_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Reference without readback, then every readback mode and format
+    RenderingConfig rendering_config = in_base_rendering_config;
+    rendering_config.readback_mode = NO_READBACK;
+    in_rendering_config_list.push_back(rendering_config);
+
+    for (unsigned int readback_mode = SYNC_READBACK; readback_mode < NB_READBACK_MODE; ++readback_mode)
+    {
+        for (unsigned int readback_format = READBACK_RGBA8; readback_format < NB_READBACK_FORMAT; ++readback_format)
+        {
+            rendering_config.readback_mode = static_cast<ReadbackMode>(readback_mode);
+            rendering_config.readback_format = static_cast<ReadbackFormat>(readback_format);
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_fill_rate_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Every method at every offscreen size : the frame time slope against the size gives the pixel cost
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        for (unsigned int framebuffer_size_id = 1; framebuffer_size_id < NB_FRAMEBUFFER_SIZES; ++framebuffer_size_id)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+            rendering_config.framebuffer_width  = FRAMEBUFFER_SIZES[framebuffer_size_id][0];
+            rendering_config.framebuffer_height = FRAMEBUFFER_SIZES[framebuffer_size_id][1];
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_scene_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Every method with more and more objects, submitted in generation order then sorted by state
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        for (unsigned int scene_objects_id = 1; scene_objects_id < NB_SCENE_OBJECTS; ++scene_objects_id)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+            rendering_config.nb_scene_objects = SCENE_OBJECTS[scene_objects_id];
+            rendering_config.rendering_options.set(TEXTURE);
+
+            rendering_config.rendering_options.reset(SORTED_SCENE);
+            in_rendering_config_list.push_back(rendering_config);
+            rendering_config.rendering_options.set(SORTED_SCENE);
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_call_list_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Every build, with strips and triangles : compile time, list memory and replay time
+    for (unsigned int call_list_build = REPLAY_CALL_LIST; call_list_build < NB_CALL_LIST_BUILD; ++call_list_build)
+    {
+        for (unsigned int triangle_strip = 0; triangle_strip < 2; ++triangle_strip)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.rendering_method = CALL_LIST;
+            rendering_config.call_list_build = static_cast<CallListBuild>(call_list_build);
+            rendering_config.rendering_options.set(TRIANGLE_STRIP, triangle_strip);
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_streaming_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Streamed models up to 100M triangles, with strips and triangles : sustained triangle rate and upload bandwidth
+    for (unsigned int triangles_id = 0; triangles_id < NB_STREAMING_BENCH_TRIANGLES; ++triangles_id)
+    {
+        for (unsigned int triangle_strip = 0; triangle_strip < 2; ++triangle_strip)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.rendering_method = STREAMING_VBO;
+            rendering_config.nb_triangles = STREAMING_BENCH_TRIANGLES[triangles_id];
+            rendering_config.nb_scene_objects = 1;
+            rendering_config.rendering_options.set(TRIANGLE_STRIP, triangle_strip);
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_procedural_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Static VBO against vertices evaluated by the GPU, with strips and triangles : setup time, memory and triangle rate
+    for (unsigned int triangles_id = 0; triangles_id < NB_PROCEDURAL_BENCH_TRIANGLES; ++triangles_id)
+    {
+        for (unsigned int triangle_strip = 0; triangle_strip < 2; ++triangle_strip)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            rendering_config.nb_triangles = PROCEDURAL_BENCH_TRIANGLES[triangles_id];
+            rendering_config.nb_scene_objects = 1;
+            rendering_config.rendering_options.set(TRIANGLE_STRIP, triangle_strip);
+
+            rendering_config.rendering_method = STATIC_VBO;
+            in_rendering_config_list.push_back(rendering_config);
+            rendering_config.rendering_method = PROCEDURAL;
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_gpu_culling_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // CPU driven static VBO against GPU culled clusters, single model then scene objects partly out of the view,
+    // with strips and triangles and with face culling so that back-facing clusters are culled too
+    for (unsigned int triangles_id = 0; triangles_id < NB_GPU_CULLING_BENCH_TRIANGLES; ++triangles_id)
+    {
+        for (unsigned int scene_objects_id = 0; scene_objects_id < 2; ++scene_objects_id)
+        {
+            for (unsigned int triangle_strip = 0; triangle_strip < 2; ++triangle_strip)
+            {
+                RenderingConfig rendering_config = in_base_rendering_config;
+                rendering_config.nb_triangles = GPU_CULLING_BENCH_TRIANGLES[triangles_id];
+                rendering_config.nb_scene_objects = SCENE_OBJECTS[scene_objects_id];
+                rendering_config.rendering_options.set(TRIANGLE_STRIP, triangle_strip);
+                rendering_config.rendering_options.reset(BACK_FACE_PAINTING);
+
+                rendering_config.rendering_method = STATIC_VBO;
+                in_rendering_config_list.push_back(rendering_config);
+                rendering_config.rendering_method = GPU_CULLED;
+                in_rendering_config_list.push_back(rendering_config);
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_multisample_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Every depth format at every sample count, offscreen since the window can not change its format
+    for (unsigned int depth_format = DEPTH_16; depth_format < NB_DEPTH_FORMAT; ++depth_format)
+    {
+        for (unsigned int samples_id = 0; samples_id < NB_MSAA_SAMPLES; ++samples_id)
+        {
+            RenderingConfig rendering_config = in_base_rendering_config;
+            if (!rendering_config.framebuffer_width || !rendering_config.framebuffer_height)
+            {
+                rendering_config.framebuffer_width  = FRAMEBUFFER_SIZES[3][0];
+                rendering_config.framebuffer_height = FRAMEBUFFER_SIZES[3][1];
+            }
+            rendering_config.depth_format = static_cast<DepthFormat>(depth_format);
+            rendering_config.nb_samples = MSAA_SAMPLES[samples_id];
+
+            in_rendering_config_list.push_back(rendering_config);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void generate_lighting_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, const RenderingConfig& in_base_rendering_config)
+{
+    // Every method unlit, then with more and more lights of each type, with an infinite and a local viewer
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        RenderingConfig rendering_config = in_base_rendering_config;
+        rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+        rendering_config.nb_lights = 0;
+        in_rendering_config_list.push_back(rendering_config);
+
+        for (unsigned int light_type = DIRECTIONAL_LIGHT; light_type < NB_LIGHT_TYPE; ++light_type)
+        {
+            for (unsigned int local_viewer = 0; local_viewer < 2; ++local_viewer)
+            {
+                for (unsigned int light_counts_id = 1; light_counts_id < NB_LIGHT_COUNTS; ++light_counts_id)
+                {
+                    rendering_config.light_type = static_cast<LightType>(light_type);
+                    rendering_config.rendering_options.set(LOCAL_VIEWER, local_viewer);
+                    rendering_config.nb_lights = LIGHT_COUNTS[light_counts_id];
+
+                    in_rendering_config_list.push_back(rendering_config);
+                }
+            }
+        }
+    }
+}
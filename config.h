@@ -0,0 +1,331 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <deque>
+#include <bitset>
+#include <ostream>
+#include <string>
+
+const unsigned int TEXTURE_SIZES[] = {2, 256, 512, 1024, 2048, 4096, 8192};
+const unsigned int NB_TEXTURE_SIZES = sizeof(TEXTURE_SIZES) / sizeof(TEXTURE_SIZES[0]);
+
+// Offscreen framebuffer sizes, the first one renders in the window
+const unsigned int FRAMEBUFFER_SIZES[][2] = {{0, 0}, {256, 256}, {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160}};
+const unsigned int NB_FRAMEBUFFER_SIZES = sizeof(FRAMEBUFFER_SIZES) / sizeof(FRAMEBUFFER_SIZES[0]);
+
+const unsigned int OVERDRAW_PASSES[] = {1, 2, 4, 8, 16};
+const unsigned int NB_OVERDRAW_PASSES = sizeof(OVERDRAW_PASSES) / sizeof(OVERDRAW_PASSES[0]);
+
+const unsigned int SCENE_OBJECTS[] = {1, 100, 1000, 10000};
+const unsigned int NB_SCENE_OBJECTS = sizeof(SCENE_OBJECTS) / sizeof(SCENE_OBJECTS[0]);
+
+const unsigned int STREAMING_BENCH_TRIANGLES[] = {1000000, 10000000, 100000000};
+const unsigned int NB_STREAMING_BENCH_TRIANGLES = sizeof(STREAMING_BENCH_TRIANGLES) / sizeof(STREAMING_BENCH_TRIANGLES[0]);
+
+const unsigned int PROCEDURAL_BENCH_TRIANGLES[] = {320000, 1000000, 10000000};
+const unsigned int NB_PROCEDURAL_BENCH_TRIANGLES = sizeof(PROCEDURAL_BENCH_TRIANGLES) / sizeof(PROCEDURAL_BENCH_TRIANGLES[0]);
+
+// Samples of the offscreen framebuffers, resolved at the end of each frame, 1 renders without resolve
+const unsigned int MSAA_SAMPLES[] = {1, 2, 4, 8};
+const unsigned int NB_MSAA_SAMPLES = sizeof(MSAA_SAMPLES) / sizeof(MSAA_SAMPLES[0]);
+
+// Lights of the fixed function pipeline guaranteed by OpenGL, the lighting bench sweeps a subset
+const unsigned int MAX_LIGHTS = 8;
+const unsigned int LIGHT_COUNTS[] = {0, 1, 2, 4, 8};
+const unsigned int NB_LIGHT_COUNTS = sizeof(LIGHT_COUNTS) / sizeof(LIGHT_COUNTS[0]);
+
+const unsigned int GPU_CULLING_BENCH_TRIANGLES[] = {1000000, 10000000};
+const unsigned int NB_GPU_CULLING_BENCH_TRIANGLES = sizeof(GPU_CULLING_BENCH_TRIANGLES) / sizeof(GPU_CULLING_BENCH_TRIANGLES[0]);
+
+extern const char* BENCH_FILE;
+extern const char* TEXTURE_BENCH_FILE;
+extern const char* READBACK_BENCH_FILE;
+extern const char* FILL_RATE_BENCH_FILE;
+extern const char* SCENE_BENCH_FILE;
+extern const char* CALL_LIST_BENCH_FILE;
+extern const char* STREAMING_BENCH_FILE;
+extern const char* PROCEDURAL_BENCH_FILE;
+extern const char* GPU_CULLING_BENCH_FILE;
+extern const char* MULTISAMPLE_BENCH_FILE;
+extern const char* LIGHTING_BENCH_FILE;
+extern const char* THREAD_BENCH_FILE;
+extern const char* VALIDATION_BENCH_FILE;
+extern const char* CAPTURE_FILE;
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum CameraMode
+{
+    TIMED_CAMERA = 0,                       // rotation speed follows the rendering time
+    FIXED_STEP_CAMERA,                      // same rotation step every frame
+    ORBIT_PATH_CAMERA,                      // orbit and zoom path indexed by the frame number
+
+    NB_CAMERA_MODE
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum SwapControl
+{
+    DRIVER_SWAP_INTERVAL = 0,
+    NO_VSYNC,
+    VSYNC,
+    ADAPTIVE_VSYNC,
+
+    NB_SWAP_CONTROL
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum RenderingMethod
+{
+    INVALID = 0,
+    IMMEDIATE,
+    CALL_LIST,
+    STATIC_VBO,
+    DYNAMIC_VBO,
+    STREAMING_VBO,                          // model generated and uploaded chunk by chunk while drawing
+    PROCEDURAL,                             // vertices evaluated by a vertex shader from gl_VertexID, no buffer
+    GPU_CULLED,                             // static VBO clusters culled by a compute shader, one indirect multi draw
+
+    NB_RENDERING_METHOD
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum CallListBuild
+{
+    REPLAY_CALL_LIST = 0,                   // immediate mode replay in a single list
+    VERTEX_ARRAY_CALL_LIST,                 // float vertex arrays in a single list
+    STRIP_CALL_LISTS,                       // float vertex arrays, one list per strip
+    COMPILE_AND_EXECUTE_CALL_LIST,          // float vertex arrays in a single list, drawn while compiled
+
+    NB_CALL_LIST_BUILD
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum RenderingOption
+{
+    TRIANGLE_STRIP = 0,
+    COLOR,
+    TEXTURE,
+    SMOOTH_SHADING,
+    BACK_FACE_PAINTING,
+
+    NB_BENCH_RENDERING_OPTION,
+
+    WIREFRAME,
+    CAPTURE,
+    FULL_SCREEN_OVERDRAW,
+    CHUNKED_UPLOAD,
+    SORTED_SCENE,
+    LOCAL_VIEWER,
+
+    NB_RENDERING_OPTION
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum TextureFormat
+{
+    TEXTURE_RGBA8 = 0,
+    TEXTURE_COMPRESSED,
+    TEXTURE_FLOAT,
+
+    NB_TEXTURE_FORMAT
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum TextureFilter
+{
+    TEXTURE_NEAREST = 0,
+    TEXTURE_TRILINEAR,
+    TEXTURE_ANISOTROPIC,
+
+    NB_TEXTURE_FILTER
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum TextureUploadMethod
+{
+    TEX_IMAGE_UPLOAD = 0,
+    TEX_SUB_IMAGE_UPLOAD,
+    PBO_UPLOAD,
+
+    NB_TEXTURE_UPLOAD_METHOD
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum BenchType
+{
+    RENDERING_BENCH = 0,
+    TEXTURE_UPLOAD_BENCH,
+    READBACK_BENCH,
+    FILL_RATE_BENCH,
+    SCENE_BENCH,
+    CALL_LIST_BENCH,
+    STREAMING_BENCH,
+    PROCEDURAL_BENCH,
+    GPU_CULLING_BENCH,
+    MULTISAMPLE_BENCH,
+    LIGHTING_BENCH,
+    THREAD_SCALING_BENCH,
+    VALIDATION_BENCH,
+
+    NB_BENCH_TYPE
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum ReadbackMode
+{
+    NO_READBACK = 0,
+    SYNC_READBACK,
+    PBO_READBACK,
+
+    NB_READBACK_MODE
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum ReadbackFormat
+{
+    READBACK_RGBA8 = 0,
+    READBACK_BGRA,
+    READBACK_DEPTH,
+
+    NB_READBACK_FORMAT
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum DepthFormat
+{
+    DEPTH_16 = 0,
+    DEPTH_24,
+    DEPTH_32F,
+
+    NB_DEPTH_FORMAT
+};
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+enum LightType
+{
+    DIRECTIONAL_LIGHT = 0,
+    POINT_LIGHT,
+    SPOT_LIGHT,
+
+    NB_LIGHT_TYPE
+};
+
+////////////////////////////////////////////////////////////////////////
+// Config structure
+////////////////////////////////////////////////////////////////////////
+struct DisplayConfig
+{
+    unsigned int windows_width;
+    unsigned int windows_height;
+    double rotation_angle_y;
+    double rotation_angle_x;
+    double move_forward;
+    bool rotation;
+    CameraMode camera_mode;
+    SwapControl swap_control;
+    bool latency_measure;                   // glFinish after the swap to estimate the input to present latency
+    bool trace;                             // record a timeline trace, written when disabled
+};
+
+struct RenderingConfig
+{
+    RenderingMethod rendering_method;
+    unsigned int nb_triangles;
+    CallListBuild call_list_build;
+
+    std::bitset<NB_RENDERING_OPTION> rendering_options;
+
+    unsigned int texture_size;
+    TextureFormat texture_format;
+    TextureFilter texture_filter;
+
+    ReadbackMode readback_mode;
+    ReadbackFormat readback_format;
+
+    unsigned int framebuffer_width;         // offscreen framebuffer size, 0 to render in the window
+    unsigned int framebuffer_height;
+    unsigned int nb_overdraw_passes;
+    unsigned int nb_samples;                // offscreen framebuffer only, the window keeps the format of its context
+    DepthFormat depth_format;
+
+    unsigned int nb_lights;                 // 0 to MAX_LIGHTS, 0 disables the lighting
+    LightType light_type;
+
+    unsigned int nb_scene_objects;          // small meshes sharing nb_triangles, 1 to draw the single model
+};
+
+struct BenchConfig
+{
+    BenchType bench_type;
+    unsigned int min_frames;                // adaptive sampling of each config
+    unsigned int max_frames;
+    double target_precision;                // relative half width of the 95% confidence interval of the median
+    unsigned int time_budget;               // s for the whole bench
+    bool resume;                            // skip the configs already in the report
+    unsigned int shard_id;                  // configs of the matrix run by this process, 1 to nb_shards
+    unsigned int nb_shards;
+};
+
+////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////
+void print_config(const RenderingConfig& in_rendering_config, std::ostream& out_stream);
+void print_display_config(const DisplayConfig& in_display_config, std::ostream& out_stream);
+void print_config_method(const RenderingConfig& in_rendering_config, std::ostream& out_stream);
+void print_bench_config(const BenchConfig& in_bench_config, std::ostream& out_stream);
+const char* bench_file_name(BenchType in_bench_type);
+std::string bench_report_name(const BenchConfig& in_bench_config);
+bool bench_type_from_file_name(const std::string& in_file_name, BenchType& out_bench_type);
+bool is_one_shot_bench(BenchType in_bench_type);
+std::string rendering_config_key(const RenderingConfig& in_rendering_config);
+bool parse_rendering_config_key(const std::string& in_key, RenderingConfig& out_rendering_config);
+const char* texture_format_name(TextureFormat in_texture_format);
+const char* texture_filter_name(TextureFilter in_texture_filter);
+const char* texture_upload_method_name(TextureUploadMethod in_upload_method);
+const char* swap_control_name(SwapControl in_swap_control);
+const char* camera_mode_name(CameraMode in_camera_mode);
+const char* call_list_build_name(CallListBuild in_call_list_build);
+const char* readback_mode_name(ReadbackMode in_readback_mode);
+const char* readback_format_name(ReadbackFormat in_readback_format);
+const char* depth_format_name(DepthFormat in_depth_format);
+const char* light_type_name(LightType in_light_type);
+unsigned int frame_nb_triangles(const RenderingConfig& in_rendering_config);
+unsigned int nb_mesh_triangles(const RenderingConfig& in_rendering_config);
+bool model_kept_in_memory(const RenderingConfig& in_rendering_config);
+void generate_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_readback_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_fill_rate_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_scene_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_call_list_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_streaming_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_procedural_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_gpu_culling_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_multisample_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
+void generate_lighting_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, const RenderingConfig& in_base_rendering_config);
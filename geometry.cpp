@@ -0,0 +1,164 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include <list>
+#include <cmath>
+
+#include "geometry.h"
+
+////////////////////////////////////////////////////////////////////////
+Vector3d compute_normal(const Vector3d& in_v1, const Vector3d& in_v2, const Vector3d& in_v3)
+{
+    Vector3d vector1 = in_v2 - in_v1;
+    Vector3d vector2 = in_v3 - in_v1;
+    Vector3d normal(vector1.y * vector2.z - vector1.z * vector2.y,    // cross product
+                    vector1.z * vector2.x - vector1.x * vector2.z,
+                    vector1.x * vector2.y - vector1.y * vector2.x);
+    return normal / sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+}
+
+////////////////////////////////////////////////////////////////////////
+void fill_normal(std::vector<Vertex>& out_vertices, unsigned int in_id1, unsigned int in_id2, unsigned int in_id3)
+{
+    Vector3d normal = compute_normal(out_vertices.at(in_id1).coord,
+                                     out_vertices.at(in_id2).coord,
+                                     out_vertices.at(in_id3).coord);
+    out_vertices.at(in_id1).normal = out_vertices.at(in_id1).normal + normal;
+    out_vertices.at(in_id2).normal = out_vertices.at(in_id2).normal + normal;
+    out_vertices.at(in_id3).normal = out_vertices.at(in_id3).normal + normal;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+size_t geometry_size(const Geometry& in_geometry)
+{
+    size_t size = in_geometry.vertices.capacity() * sizeof(Vertex);
+    for (std::list<TriangleStrip>::const_iterator it = in_geometry.triangles_strip.begin(); it != in_geometry.triangles_strip.end(); ++it)
+    {
+        size += sizeof(TriangleStrip) + (*it).vertex_ids.capacity() * sizeof(unsigned int);
+    }
+    return size;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int nb_grid_subdivisions(unsigned int in_nb_triangles)
+{
+    return static_cast<int>(sqrt(static_cast<double>(in_nb_triangles) / 2.0) + 0.5);
+}
+
+////////////////////////////////////////////////////////////////////////
+void generate_geometry(unsigned int in_nb_triangles, Geometry& out_geometry)
+{
+    const unsigned int nb_subdivisions = nb_grid_subdivisions(in_nb_triangles);
+    generate_geometry_rows(nb_subdivisions, 0, nb_subdivisions, out_geometry);
+}
+
+////////////////////////////////////////////////////////////////////////
+void generate_geometry_rows(unsigned int in_nb_subdivisions, unsigned int in_first_row, unsigned int in_last_row, Geometry& out_geometry)
+{
+    out_geometry.vertices.clear();
+    out_geometry.triangles_strip.clear();
+
+    const double texture_coef = 10.0;
+
+    // Vertex generation
+    for (unsigned int i = in_first_row; i <= in_last_row; ++i)
+    {
+        double ratio_i = static_cast<double>(i) / static_cast<double>(in_nb_subdivisions);
+
+        const Vector3d color(1.0 - ratio_i, ratio_i, 1.0 - ratio_i);
+
+        for (unsigned int j = 0; j <= in_nb_subdivisions; ++j)
+        {
+            double ratio_j = static_cast<double>(j) / static_cast<double>(in_nb_subdivisions);
+
+            // Theta and phi
+            const double theta = -M_PI / 2.0 + M_PI * ratio_i;
+            const double phi = 2.0 * M_PI * ratio_j;
+
+            // Construction of vertex
+            Vertex v;
+
+            // Polar equation of a pseudo-donuts
+            v.coord  = Vector3d(cos(theta) * cos(phi), cos(theta) * sin(phi), sin(theta) * cos(theta));
+            v.color  = color;
+            v.normal = Vector3d(0.0, 0.0, 0.0);
+            v.texture_coordinate = Vector3d(texture_coef * ratio_i, texture_coef * ratio_j, 0.0);
+
+            out_geometry.vertices.push_back(v);
+        }
+    }
+
+    // Triangle generation, vertex ids are relative to the first row
+    for (unsigned int i = 0; i < in_last_row - in_first_row; ++i)
+    {
+        TriangleStrip triangle_strip;
+        for (unsigned int j = 0; j <= in_nb_subdivisions; ++j)
+        {
+            triangle_strip.vertex_ids.push_back(j + (i + 1) * (in_nb_subdivisions + 1));
+            triangle_strip.vertex_ids.push_back(j +  i      * (in_nb_subdivisions + 1));
+        }
+        out_geometry.triangles_strip.push_back(triangle_strip);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void compute_normals(Geometry& io_geometry)
+{
+    // The grid has one strip per row of quads, the first and last rows are its borders
+    const unsigned int nb_rows = io_geometry.triangles_strip.size();
+    const unsigned int row_size = io_geometry.vertices.size() / (nb_rows + 1);
+
+    for (std::vector<Vertex>::iterator it = io_geometry.vertices.begin(); it != io_geometry.vertices.end(); ++it)
+    {
+        it->normal = Vector3d(0.0, 0.0, 0.0);
+    }
+
+    // Compute the normal direction of each vertex with the sum of neighbor triangle's normal
+    for (unsigned int i = 0; i < nb_rows; ++i)
+    {
+        for (unsigned int j = 0; j + 1 < row_size; ++j)
+        {
+            fill_normal(io_geometry.vertices,
+                        j + i * row_size,
+                        (j + 1) + i * row_size,
+                        j + (i + 1) * row_size);
+            fill_normal(io_geometry.vertices,
+                        j + (i + 1) * row_size,
+                        (j + 1) + i * row_size,
+                        (j + 1) + (i + 1) * row_size);
+        }
+
+        Vector3d sum_normal_extremum = io_geometry.vertices.at(i * row_size).normal + io_geometry.vertices.at(row_size - 1 + i * row_size).normal;
+        io_geometry.vertices.at(i * row_size).normal = sum_normal_extremum;
+        io_geometry.vertices.at(row_size - 1 + i * row_size).normal = sum_normal_extremum;
+    }
+
+    // Normalize the direction computed before, with the number of neighbor triangle
+    for (unsigned int i = 0; i <= nb_rows; ++i)
+    {
+        for (unsigned int j = 0; j < row_size; ++j)
+        {
+            if (i == 0 || i == nb_rows)
+            {
+                io_geometry.vertices.at(j + i * row_size).normal = io_geometry.vertices.at(j + i * row_size).normal / 3.0;
+            }
+            else
+            {
+                io_geometry.vertices.at(j + i * row_size).normal = io_geometry.vertices.at(j + i * row_size).normal / 6.0;
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <list>
+
+////////////////////////////////////////////////////////////////////////
+// Vector structure
+////////////////////////////////////////////////////////////////////////
+struct Vector3d
+{
+    // methods
+    Vector3d() {}
+    Vector3d(double in_x, double in_y, double in_z) : x(in_x), y(in_y), z(in_z) {}
+    inline Vector3d operator+(const Vector3d& in_v) const { return Vector3d(x + in_v.x, y + in_v.y, z + in_v.z); }
+    inline Vector3d operator-(const Vector3d& in_v) const { return Vector3d(x - in_v.x, y - in_v.y, z - in_v.z); }
+    inline Vector3d operator*(double in_a) const { return Vector3d(x * in_a, y * in_a, z * in_a); }
+    inline Vector3d operator/(double in_a) const { return Vector3d(x / in_a, y / in_a, z / in_a); }
+
+    // members
+    double x, y, z;
+};
+
+////////////////////////////////////////////////////////////////////////
+// Model structure
+////////////////////////////////////////////////////////////////////////
+struct Vertex
+{
+    Vector3d coord;
+    Vector3d normal;
+    Vector3d color;
+    Vector3d texture_coordinate;
+};
+
+struct TriangleStrip
+{
+    std::vector<unsigned int> vertex_ids;
+};
+
+struct Geometry
+{
+    std::vector<Vertex> vertices;
+    std::list<TriangleStrip> triangles_strip;
+};
+
+////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////
+unsigned int nb_grid_subdivisions(unsigned int in_nb_triangles);
+void generate_geometry(unsigned int in_nb_triangles, Geometry& out_geometry);
+void generate_geometry_rows(unsigned int in_nb_subdivisions, unsigned int in_first_row, unsigned int in_last_row, Geometry& out_geometry);
+void compute_normals(Geometry& io_geometry);
+Vector3d compute_normal(const Vector3d& in_v1, const Vector3d& in_v2, const Vector3d& in_v3);
+void fill_normal(std::vector<Vertex>& out_vertices, unsigned int in_id1, unsigned int in_id2, unsigned int in_id3);
+size_t geometry_size(const Geometry& in_geometry);
@@ -0,0 +1,132 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+// Empty without GLBENCH_GL_COUNTERS
+#ifdef GLBENCH_GL_COUNTERS
+
+#include <iostream>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+#include "gl_counters.h"
+#include "stats.h"
+
+__thread GlCounters gl_counters;
+__thread GlCounters gl_setup_counters;
+
+////////////////////////////////////////////////////////////////////////
+void clear_gl_counters(GlCounters& out_gl_counters)
+{
+    out_gl_counters.nb_frames = 0;
+    out_gl_counters.nb_calls = 0;
+    out_gl_counters.nb_draw_calls = 0;
+    out_gl_counters.nb_state_calls = 0;
+    out_gl_counters.nb_vertices = 0;
+    out_gl_counters.nb_bytes = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void add_gl_counters(GlCounters& io_sum_counters, const GlCounters& in_gl_counters)
+{
+    io_sum_counters.nb_frames += in_gl_counters.nb_frames;
+    io_sum_counters.nb_calls += in_gl_counters.nb_calls;
+    io_sum_counters.nb_draw_calls += in_gl_counters.nb_draw_calls;
+    io_sum_counters.nb_state_calls += in_gl_counters.nb_state_calls;
+    io_sum_counters.nb_vertices += in_gl_counters.nb_vertices;
+    io_sum_counters.nb_bytes += in_gl_counters.nb_bytes;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_gl_counters(std::ostream& out_stream, const GlCounters& in_frame_counters, const GlCounters& in_setup_counters)
+{
+    const double mega_byte = 1024.0 * 1024.0;
+
+    if (in_frame_counters.nb_frames)
+    {
+        const double nb_frames = in_frame_counters.nb_frames;
+        out_stream << "| GL per frame : ";
+        print_fixed(out_stream, in_frame_counters.nb_calls / nb_frames, 0);
+        out_stream << " calls (";
+        print_fixed(out_stream, in_frame_counters.nb_draw_calls / nb_frames, 0);
+        out_stream << " draws, ";
+        print_fixed(out_stream, in_frame_counters.nb_state_calls / nb_frames, 0);
+        out_stream << " state), ";
+        print_fixed(out_stream, in_frame_counters.nb_vertices / nb_frames / 1000.0, 1);
+        out_stream << " kvertices, ";
+        print_fixed(out_stream, in_frame_counters.nb_bytes / nb_frames / mega_byte, 2);
+        out_stream << " MB ";
+    }
+    out_stream << "| GL setup : " << in_setup_counters.nb_calls << " calls, ";
+    print_fixed(out_stream, in_setup_counters.nb_bytes / mega_byte, 1);
+    out_stream << " MB      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_thread_gl_counters(std::ostream& out_stream, const GlCounters& in_sum_counters)
+{
+    // Frames of every thread, so the figures are per frame of one thread
+    if (!in_sum_counters.nb_frames)
+    {
+        return;
+    }
+    const double nb_frames = in_sum_counters.nb_frames;
+    out_stream << ", GL per frame ";
+    print_fixed(out_stream, in_sum_counters.nb_calls / nb_frames, 0);
+    out_stream << " calls (";
+    print_fixed(out_stream, in_sum_counters.nb_draw_calls / nb_frames, 0);
+    out_stream << " draws), ";
+    print_fixed(out_stream, in_sum_counters.nb_vertices / nb_frames / 1000.0, 1);
+    out_stream << " kvertices, ";
+    print_fixed(out_stream, in_sum_counters.nb_bytes / nb_frames / (1024.0 * 1024.0), 2);
+    out_stream << " MB";
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned long gl_sum_counts(const GLsizei* in_counts, GLsizei in_nb_draws)
+{
+    unsigned long nb_vertices = 0;
+    for (GLsizei i = 0; i < in_nb_draws; ++i)
+    {
+        nb_vertices += in_counts[i];
+    }
+    return nb_vertices;
+}
+
+////////////////////////////////////////////////////////////////////////
+size_t gl_pixel_size(GLenum in_format, GLenum in_type)
+{
+    // Packed pixel types hold a whole pixel
+    if (in_type == GL_UNSIGNED_INT_8_8_8_8 || in_type == GL_UNSIGNED_INT_8_8_8_8_REV || in_type == GL_UNSIGNED_INT_24_8)
+    {
+        return 4;
+    }
+
+    size_t nb_components = 4;
+    if (in_format == GL_RGB || in_format == GL_BGR)
+        nb_components = 3;
+    else if (in_format == GL_DEPTH_COMPONENT || in_format == GL_RED || in_format == GL_ALPHA || in_format == GL_LUMINANCE)
+        nb_components = 1;
+
+    size_t component_size = 1;
+    if (in_type == GL_FLOAT || in_type == GL_UNSIGNED_INT || in_type == GL_INT)
+        component_size = 4;
+    else if (in_type == GL_UNSIGNED_SHORT || in_type == GL_SHORT || in_type == GL_HALF_FLOAT)
+        component_size = 2;
+
+    return nb_components * component_size;
+}
+
+#endif
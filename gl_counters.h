@@ -0,0 +1,143 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+#include <GL/gl.h>
+
+////////////////////////////////////////////////////////////////////////
+// GL call counters, built with -DGLBENCH_GL_COUNTERS (make GL_COUNTERS=1)
+// Macros wrap the GL entry points used by glbench, without the flag the hooks expand to nothing
+////////////////////////////////////////////////////////////////////////
+#ifdef GLBENCH_GL_COUNTERS
+
+struct GlCounters
+{
+    unsigned int nb_frames;
+    unsigned long nb_calls;                 // every wrapped GL call
+    unsigned long nb_draw_calls;            // glBegin, glDrawElements, glMultiDraw* and glCallList
+    unsigned long nb_state_calls;           // state setters, bindings and client arrays
+    unsigned long nb_vertices;              // glVertex calls and drawn indices, not known for indirect draws
+    size_t nb_bytes;                        // buffer, texture and readback transfers
+};
+
+// Thread local : the workers of the thread scaling bench count their own calls, summed by the main thread
+extern __thread GlCounters gl_counters;             // since the first frame of the config
+extern __thread GlCounters gl_setup_counters;       // from init_gl to the end of the first frame
+
+void clear_gl_counters(GlCounters& out_gl_counters);
+void add_gl_counters(GlCounters& io_sum_counters, const GlCounters& in_gl_counters);
+void print_gl_counters(std::ostream& out_stream, const GlCounters& in_frame_counters, const GlCounters& in_setup_counters);
+void print_thread_gl_counters(std::ostream& out_stream, const GlCounters& in_sum_counters);
+size_t gl_pixel_size(GLenum in_format, GLenum in_type);
+unsigned long gl_sum_counts(const GLsizei* in_counts, GLsizei in_nb_draws);
+
+#define GL_COUNT_CALL()         (++gl_counters.nb_calls)
+#define GL_COUNT_STATE()        (++gl_counters.nb_calls, ++gl_counters.nb_state_calls)
+#define GL_COUNT_VERTEX()       (++gl_counters.nb_calls, ++gl_counters.nb_vertices)
+#define GL_COUNT_DRAW(n)        (++gl_counters.nb_calls, ++gl_counters.nb_draw_calls, gl_counters.nb_vertices += (n))
+#define GL_COUNT_BYTES(n)       (gl_counters.nb_bytes += (n))
+
+#define GL_COUNTERS_BEGIN_SETUP()   clear_gl_counters(gl_counters)
+#define GL_COUNTERS_END_SETUP()     (gl_setup_counters = gl_counters, clear_gl_counters(gl_counters))
+#define GL_COUNTERS_END_FRAME()     (++gl_counters.nb_frames)
+#define GL_COUNTERS_PRINT(stream)   print_gl_counters(stream, gl_counters, gl_setup_counters)
+#define GL_COUNTERS_BEGIN_THREAD()  clear_gl_counters(gl_counters)
+#define GL_COUNTERS_END_THREAD(out_counters)    ((out_counters) = gl_counters)
+
+// Immediate mode
+#define glBegin(mode)           (GL_COUNT_DRAW(0), glBegin(mode))
+#define glVertex2d(x, y)        (GL_COUNT_VERTEX(), glVertex2d(x, y))
+#define glVertex3d(x, y, z)     (GL_COUNT_VERTEX(), glVertex3d(x, y, z))
+#define glNormal3d(x, y, z)     (GL_COUNT_CALL(), glNormal3d(x, y, z))
+#define glColor3d(r, g, b)      (GL_COUNT_CALL(), glColor3d(r, g, b))
+#define glColor4d(r, g, b, a)   (GL_COUNT_CALL(), glColor4d(r, g, b, a))
+#define glTexCoord2d(s, t)      (GL_COUNT_CALL(), glTexCoord2d(s, t))
+
+// Draws
+#define glDrawElements(mode, count, type, indices)  (GL_COUNT_DRAW(count), glDrawElements(mode, count, type, indices))
+#define glCallList(list)                            (GL_COUNT_DRAW(0), glCallList(list))
+#define glMultiDrawArrays(mode, first, count, drawcount) \
+    (GL_COUNT_DRAW(gl_sum_counts(count, drawcount)), glMultiDrawArrays(mode, first, count, drawcount))
+#define glMultiDrawElementsIndirect(mode, type, indirect, drawcount, stride) \
+    (GL_COUNT_DRAW(0), glMultiDrawElementsIndirect(mode, type, indirect, drawcount, stride))
+#define glDispatchCompute(x, y, z)                  (GL_COUNT_CALL(), glDispatchCompute(x, y, z))
+#define glBlitFramebuffer(x0, y0, x1, y1, dx0, dy0, dx1, dy1, mask, filter) \
+    (GL_COUNT_CALL(), glBlitFramebuffer(x0, y0, x1, y1, dx0, dy0, dx1, dy1, mask, filter))
+
+// State
+#define glEnable(cap)                               (GL_COUNT_STATE(), glEnable(cap))
+#define glDisable(cap)                              (GL_COUNT_STATE(), glDisable(cap))
+#define glEnableClientState(array)                  (GL_COUNT_STATE(), glEnableClientState(array))
+#define glDisableClientState(array)                 (GL_COUNT_STATE(), glDisableClientState(array))
+#define glPolygonMode(face, mode)                   (GL_COUNT_STATE(), glPolygonMode(face, mode))
+#define glDepthFunc(func)                           (GL_COUNT_STATE(), glDepthFunc(func))
+#define glCullFace(mode)                            (GL_COUNT_STATE(), glCullFace(mode))
+#define glShadeModel(mode)                          (GL_COUNT_STATE(), glShadeModel(mode))
+#define glBlendFunc(sfactor, dfactor)               (GL_COUNT_STATE(), glBlendFunc(sfactor, dfactor))
+#define glLightModeli(pname, param)                 (GL_COUNT_STATE(), glLightModeli(pname, param))
+#define glLightf(light, pname, param)               (GL_COUNT_STATE(), glLightf(light, pname, param))
+#define glLightfv(light, pname, params)             (GL_COUNT_STATE(), glLightfv(light, pname, params))
+#define glMaterialfv(face, pname, params)           (GL_COUNT_STATE(), glMaterialfv(face, pname, params))
+#define glTexParameteri(target, pname, param)       (GL_COUNT_STATE(), glTexParameteri(target, pname, param))
+#define glBindTexture(target, texture)              (GL_COUNT_STATE(), glBindTexture(target, texture))
+#define glBindBuffer(target, buffer)                (GL_COUNT_STATE(), glBindBuffer(target, buffer))
+#define glVertexPointer(size, type, stride, p)      (GL_COUNT_STATE(), glVertexPointer(size, type, stride, p))
+#define glNormalPointer(type, stride, p)            (GL_COUNT_STATE(), glNormalPointer(type, stride, p))
+#define glColorPointer(size, type, stride, p)       (GL_COUNT_STATE(), glColorPointer(size, type, stride, p))
+#define glTexCoordPointer(size, type, stride, p)    (GL_COUNT_STATE(), glTexCoordPointer(size, type, stride, p))
+#define glUseProgram(program)                       (GL_COUNT_STATE(), glUseProgram(program))
+#define glUniform1i(location, value)                (GL_COUNT_STATE(), glUniform1i(location, value))
+#define glUniform3fv(location, count, value)        (GL_COUNT_STATE(), glUniform3fv(location, count, value))
+#define glUniform4fv(location, count, value)        (GL_COUNT_STATE(), glUniform4fv(location, count, value))
+#define glBindBufferBase(target, index, buffer)     (GL_COUNT_STATE(), glBindBufferBase(target, index, buffer))
+
+// Transfers, buffers allocated without data transfer nothing
+#define glBufferData(target, size, data, usage) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES((data) ? static_cast<size_t>(size) : 0), glBufferData(target, size, data, usage))
+#define glBufferSubData(target, offset, size, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(size)), glBufferSubData(target, offset, size, data))
+#define glTexImage2D(target, level, internal_format, width, height, border, format, type, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES((data) ? static_cast<size_t>(width) * (height) * gl_pixel_size(format, type) : 0), \
+     glTexImage2D(target, level, internal_format, width, height, border, format, type, data))
+#define glTexSubImage2D(target, level, x, y, width, height, format, type, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(width) * (height) * gl_pixel_size(format, type)), \
+     glTexSubImage2D(target, level, x, y, width, height, format, type, data))
+#define glCompressedTexImage2D(target, level, internal_format, width, height, border, size, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(size)), glCompressedTexImage2D(target, level, internal_format, width, height, border, size, data))
+#define glCompressedTexSubImage2D(target, level, x, y, width, height, format, size, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(size)), glCompressedTexSubImage2D(target, level, x, y, width, height, format, size, data))
+#define glCopyBufferSubData(read_target, write_target, read_offset, write_offset, size) \
+    (GL_COUNT_CALL(), glCopyBufferSubData(read_target, write_target, read_offset, write_offset, size))
+#define glGetBufferSubData(target, offset, size, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(size)), glGetBufferSubData(target, offset, size, data))
+#define glReadPixels(x, y, width, height, format, type, data) \
+    (GL_COUNT_CALL(), GL_COUNT_BYTES(static_cast<size_t>(width) * (height) * gl_pixel_size(format, type)), \
+     glReadPixels(x, y, width, height, format, type, data))
+
+#else
+
+#define GL_COUNT_BYTES(n)
+#define GL_COUNTERS_BEGIN_SETUP()
+#define GL_COUNTERS_END_SETUP()
+#define GL_COUNTERS_END_FRAME()
+#define GL_COUNTERS_PRINT(stream)
+#define GL_COUNTERS_BEGIN_THREAD()
+#define GL_COUNTERS_END_THREAD(out_counters)
+
+#endif
@@ -15,41 +15,302 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <string>
 #include <vector>
 #include <deque>
 #include <list>
 #include <cmath>
+#include <algorithm>
 
 #include <sys/time.h>
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <SDL/SDL.h>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <GL/glext.h>
+#include <GL/glx.h>
 
 #include "main.h"
 
 #define BUFFER_OFFSET_CAST(i) reinterpret_cast<void*>(i)
 
 ////////////////////////////////////////////////////////////////////////
-// GL extensions for VBO
+// GL extensions for VBO and PBO
 ////////////////////////////////////////////////////////////////////////
 PFNGLGENBUFFERSPROC    glGenBuffers    = 0;
 PFNGLBINDBUFFERPROC    glBindBuffer    = 0;
 PFNGLBUFFERDATAPROC    glBufferData    = 0;
+PFNGLBUFFERSUBDATAPROC glBufferSubData = 0;
 PFNGLDELETEBUFFERSPROC glDeleteBuffers = 0;
+PFNGLMAPBUFFERPROC     glMapBuffer     = 0;
+PFNGLUNMAPBUFFERPROC   glUnmapBuffer   = 0;
 
-const unsigned int NB_MIN_FRAME = 30;
+////////////////////////////////////////////////////////////////////////
+// GL extensions for sync objects
+////////////////////////////////////////////////////////////////////////
+PFNGLFENCESYNCPROC      glFenceSync      = 0;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync = 0;
+PFNGLDELETESYNCPROC     glDeleteSync     = 0;
+
+////////////////////////////////////////////////////////////////////////
+// GL extensions for FBO
+////////////////////////////////////////////////////////////////////////
+PFNGLGENFRAMEBUFFERSPROC         glGenFramebuffers         = 0;
+PFNGLBINDFRAMEBUFFERPROC         glBindFramebuffer         = 0;
+PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer = 0;
+PFNGLCHECKFRAMEBUFFERSTATUSPROC  glCheckFramebufferStatus  = 0;
+PFNGLDELETEFRAMEBUFFERSPROC      glDeleteFramebuffers      = 0;
+PFNGLGENRENDERBUFFERSPROC        glGenRenderbuffers        = 0;
+PFNGLBINDRENDERBUFFERPROC        glBindRenderbuffer        = 0;
+PFNGLRENDERBUFFERSTORAGEPROC     glRenderbufferStorage     = 0;
+PFNGLDELETERENDERBUFFERSPROC     glDeleteRenderbuffers     = 0;
+PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC glRenderbufferStorageMultisample = 0;
+PFNGLBLITFRAMEBUFFERPROC                glBlitFramebuffer                = 0;
+
+////////////////////////////////////////////////////////////////////////
+// GL extensions for timer queries and debug groups
+////////////////////////////////////////////////////////////////////////
+PFNGLGENQUERIESPROC          glGenQueries          = 0;
+PFNGLDELETEQUERIESPROC       glDeleteQueries       = 0;
+PFNGLGETQUERYOBJECTIVPROC    glGetQueryObjectiv    = 0;
+PFNGLQUERYCOUNTERPROC        glQueryCounter        = 0;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = 0;
+PFNGLGETINTEGER64VPROC       glGetInteger64v       = 0;
+PFNGLPUSHDEBUGGROUPPROC      glPushDebugGroup      = 0;
+PFNGLPOPDEBUGGROUPPROC       glPopDebugGroup       = 0;
+
+////////////////////////////////////////////////////////////////////////
+// GL extensions for GLSL programs and multi draws
+////////////////////////////////////////////////////////////////////////
+PFNGLCREATESHADERPROC       glCreateShader       = 0;
+PFNGLSHADERSOURCEPROC       glShaderSource       = 0;
+PFNGLCOMPILESHADERPROC      glCompileShader      = 0;
+PFNGLGETSHADERIVPROC        glGetShaderiv        = 0;
+PFNGLGETSHADERINFOLOGPROC   glGetShaderInfoLog   = 0;
+PFNGLDELETESHADERPROC       glDeleteShader       = 0;
+PFNGLCREATEPROGRAMPROC      glCreateProgram      = 0;
+PFNGLATTACHSHADERPROC       glAttachShader       = 0;
+PFNGLLINKPROGRAMPROC        glLinkProgram        = 0;
+PFNGLGETPROGRAMIVPROC       glGetProgramiv       = 0;
+PFNGLGETPROGRAMINFOLOGPROC  glGetProgramInfoLog  = 0;
+PFNGLDELETEPROGRAMPROC      glDeleteProgram      = 0;
+PFNGLUSEPROGRAMPROC         glUseProgram         = 0;
+PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation = 0;
+PFNGLUNIFORM1IPROC          glUniform1i          = 0;
+PFNGLMULTIDRAWARRAYSPROC    glMultiDrawArrays    = 0;
+
+////////////////////////////////////////////////////////////////////////
+// GL extensions for compute shaders and indirect draws
+////////////////////////////////////////////////////////////////////////
+PFNGLDISPATCHCOMPUTEPROC           glDispatchCompute           = 0;
+PFNGLMEMORYBARRIERPROC             glMemoryBarrier             = 0;
+PFNGLBINDBUFFERBASEPROC            glBindBufferBase            = 0;
+PFNGLGETBUFFERSUBDATAPROC          glGetBufferSubData          = 0;
+PFNGLCOPYBUFFERSUBDATAPROC         glCopyBufferSubData         = 0;
+PFNGLUNIFORM3FVPROC                glUniform3fv                = 0;
+PFNGLUNIFORM4FVPROC                glUniform4fv                = 0;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect = 0;
+
+////////////////////////////////////////////////////////////////////////
+// Timeline trace, global so that any function can record a span
+////////////////////////////////////////////////////////////////////////
+TraceData trace_data;
+
+const unsigned int TEXTURE_UPLOAD_MIN_SIZE = 256;
+const unsigned int TEXTURE_UPLOAD_MIN_BYTES = 256 * 1024 * 1024;
+const unsigned int TEXTURE_UPLOAD_MIN_COUNT = 4;
+
+const unsigned int READBACK_RING_SIZE = 3;
+const GLuint64 READBACK_FENCE_TIMEOUT = 1000000000; // ns
+
+const double OVERDRAW_LAYER_ALPHA = 0.05;
+
+// Lights turn around the view axis from the single light of the default config, at 2 units of the model
+const GLfloat LIGHT_LINEAR_ATTENUATION = 0.2f;
+const GLfloat SPOT_LIGHT_CUTOFF = 45.0f;    // degrees, the model fits in the cone
+const GLfloat SPOT_LIGHT_EXPONENT = 2.0f;
+
+// Vertices and indices packed and uploaded at once by the chunked upload
+const unsigned int UPLOAD_CHUNK_NB_VERTICES = 64 * 1024;
+const unsigned int UPLOAD_CHUNK_NB_INDICES = 256 * 1024;
+
+// Streamed model chunks, the ring bounds the GPU memory whatever the model size
+const unsigned int STREAMING_CHUNK_NB_TRIANGLES = 256 * 1024;
+const unsigned int STREAMING_RING_SIZE = 3;
+const GLuint64 STREAMING_FENCE_TIMEOUT = 1000000000; // ns
+
+const unsigned int SCENE_SEED = 12345;
+const unsigned int SCENE_NB_MATERIALS = 8;
+
+const unsigned int THREAD_COUNTS[] = {1, 2, 4, 8, 16};
+const unsigned int NB_THREAD_COUNTS = sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]);
+const unsigned int THREAD_BENCH_NB_FRAMES = NB_MIN_FRAME;
+
+// Validation renders every config into a small framebuffer and compares it to the immediate mode
+const unsigned int VALIDATION_FRAMEBUFFER_SIZE = 256;
+const double VALIDATION_MIN_PSNR = 40.0;    // dB
+const int VALIDATION_PIXEL_TOLERANCE = 8;   // per channel difference counted as a different pixel
+
+const unsigned int TRACE_MAX_EVENTS = 1000000;
+const unsigned int TRACE_QUERY_RING_SIZE = 4;  // frames in flight for GPU timestamps
+const unsigned int MULTISAMPLE_QUERY_RING_SIZE = 4;
+
+// A config started this many times without a result crashed the bench each time, resumed runs skip it
+const unsigned int BENCH_MAX_ATTEMPTS = 2;
+const std::string BENCH_MATRIX_LINE = " - Config matrix .................. ";
+const std::string BENCH_RENDERER_LINE = " - Renderer ....................... ";   // last line of the report header
+const std::string BENCH_END_LINE = "| end of bench run";
 
 const double default_rotation_angle_x = -10.0;
 const double default_rotation_angle_y = -20.0;
-
-const char* BENCH_FILE = "bench.txt";
+const double default_move_forward = -1.5;
+
+const double CAMERA_STEP_ANGLE = 0.5;       // degrees per frame
+const unsigned int CAMERA_PATH_NB_FRAMES = 360;
+
+const char* TRACE_FILE = "trace.json";
+
+// Same surface, colors and texture coordinates as generate_geometry_rows, vertex ids in the order of the index buffer.
+// Lighting is the fixed function one of set_gl_state : color material for ambient and diffuse, the enabled lights, two sides.
+const char* PROCEDURAL_VERTEX_SHADER =
+    "#version 130\n"
+    "uniform int nb_subdivisions;\n"
+    "uniform bool triangle_strip;\n"
+    "uniform bool vertex_color;\n"
+    "uniform int nb_lights;\n"
+    "uniform bool local_viewer;\n"
+    "const float PI = 3.14159265358979;\n"
+    "\n"
+    "vec4 light_color(vec3 position, vec3 normal, vec4 color, vec4 emission, vec4 specular, float shininess)\n"
+    "{\n"
+    "    if (nb_lights == 0)\n"
+    "    {\n"
+    "        return color;\n"
+    "    }\n"
+    "    vec3 eye_direction = local_viewer ? -normalize(position) : vec3(0.0, 0.0, 1.0);\n"
+    "    vec3 lit = emission.rgb + gl_LightModel.ambient.rgb * color.rgb;\n"
+    "    for (int i = 0; i < nb_lights; ++i)\n"
+    "    {\n"
+    "        vec3 light_direction = gl_LightSource[i].position.xyz;\n"
+    "        float attenuation = 1.0;\n"
+    "        if (gl_LightSource[i].position.w != 0.0)\n"
+    "        {\n"
+    "            light_direction = light_direction / gl_LightSource[i].position.w - position;\n"
+    "            float light_distance = length(light_direction);\n"
+    "            attenuation = 1.0 / (gl_LightSource[i].constantAttenuation + gl_LightSource[i].linearAttenuation * light_distance\n"
+    "                                 + gl_LightSource[i].quadraticAttenuation * light_distance * light_distance);\n"
+    "        }\n"
+    "        light_direction = normalize(light_direction);\n"
+    "        if (gl_LightSource[i].spotCutoff != 180.0)\n"
+    "        {\n"
+    "            float spot = dot(-light_direction, normalize(gl_LightSource[i].spotDirection));\n"
+    "            attenuation *= (spot < gl_LightSource[i].spotCosCutoff) ? 0.0 : pow(spot, gl_LightSource[i].spotExponent);\n"
+    "        }\n"
+    "        lit += attenuation * gl_LightSource[i].ambient.rgb * color.rgb;\n"
+    "        float diffuse = dot(normal, light_direction);\n"
+    "        if (diffuse > 0.0)\n"
+    "        {\n"
+    "            vec3 half_vector = normalize(light_direction + eye_direction);\n"
+    "            lit += attenuation * (diffuse * gl_LightSource[i].diffuse.rgb * color.rgb\n"
+    "                                  + pow(max(dot(normal, half_vector), 0.0), shininess) * gl_LightSource[i].specular.rgb * specular.rgb);\n"
+    "        }\n"
+    "    }\n"
+    "    return vec4(lit, color.a);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    int strip_size = 2 * (nb_subdivisions + 1);\n"
+    "    int strip_id;\n"
+    "    int strip_vertex;\n"
+    "    if (triangle_strip)\n"
+    "    {\n"
+    "        strip_id = gl_VertexID / strip_size;\n"
+    "        strip_vertex = gl_VertexID - strip_id * strip_size;\n"
+    "    }\n"
+    "    else\n"
+    "    {\n"
+    "        int strip_triangles_size = 3 * (strip_size - 2);\n"
+    "        strip_id = gl_VertexID / strip_triangles_size;\n"
+    "        int triangle_vertex = gl_VertexID - strip_id * strip_triangles_size;\n"
+    "        int triangle_id = triangle_vertex / 3;\n"
+    "        int corner = triangle_vertex - 3 * triangle_id;\n"
+    "        strip_vertex = triangle_id + (((triangle_id & 1) == 0) ? corner : 2 - corner);\n"
+    "    }\n"
+    "\n"
+    "    // Strips go from row i + 1 to row i\n"
+    "    float ratio_i = float(strip_id + 1 - (strip_vertex & 1)) / float(nb_subdivisions);\n"
+    "    float ratio_j = float(strip_vertex / 2) / float(nb_subdivisions);\n"
+    "    float theta = -PI / 2.0 + PI * ratio_i;\n"
+    "    float phi = 2.0 * PI * ratio_j;\n"
+    "\n"
+    "    // Polar equation of a pseudo-donuts, its analytic normal is defined at the poles too\n"
+    "    vec4 coord = vec4(cos(theta) * cos(phi), cos(theta) * sin(phi), sin(theta) * cos(theta), 1.0);\n"
+    "    vec3 normal = vec3(cos(2.0 * theta) * cos(phi), cos(2.0 * theta) * sin(phi), sin(theta));\n"
+    "    vec4 color = vertex_color ? vec4(1.0 - ratio_i, ratio_i, 1.0 - ratio_i, 1.0) : vec4(1.0);\n"
+    "\n"
+    "    vec3 position = (gl_ModelViewMatrix * coord).xyz;\n"
+    "    normal = normalize(gl_NormalMatrix * normal);\n"
+    "    gl_FrontColor = light_color(position, normal, color, gl_FrontMaterial.emission, gl_FrontMaterial.specular, gl_FrontMaterial.shininess);\n"
+    "    gl_BackColor = light_color(position, -normal, color, gl_BackMaterial.emission, gl_BackMaterial.specular, gl_BackMaterial.shininess);\n"
+    "    gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(10.0 * ratio_i, 10.0 * ratio_j, 0.0, 1.0);\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * coord;\n"
+    "}\n";
+
+// One invocation per cluster, planes and eye in object space. Back-facing test of a sphere and a normal cone
+// (sine of the half angle in cone.w) : every normal of the cone points away from every point of the sphere.
+const unsigned int CULLING_GROUP_SIZE = 64;
+const char* CULLING_COMPUTE_SHADER =
+    "#version 430\n"
+    "layout(local_size_x = 64) in;\n"
+    "struct Cluster { vec4 sphere; vec4 cone; uint first_index; uint nb_indices; uint padding0; uint padding1; };\n"
+    "struct DrawCommand { uint count; uint instance_count; uint first_index; uint base_vertex; uint base_instance; };\n"
+    "layout(std430, binding = 0) readonly buffer Clusters { Cluster clusters[]; };\n"
+    "layout(std430, binding = 1) writeonly buffer Commands { DrawCommand commands[]; };\n"
+    "layout(std430, binding = 2) buffer Counters { uint nb_frustum_culled; uint nb_cone_culled; };\n"
+    "uniform int nb_clusters;\n"
+    "uniform vec4 frustum_planes[6];\n"
+    "uniform vec3 eye_position;\n"
+    "uniform bool cone_culling;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    int cluster_id = int(gl_GlobalInvocationID.x);\n"
+    "    if (cluster_id >= nb_clusters)\n"
+    "        return;\n"
+    "    Cluster cluster = clusters[cluster_id];\n"
+    "\n"
+    "    bool visible = true;\n"
+    "    for (int i = 0; i < 6; ++i)\n"
+    "    {\n"
+    "        if (dot(frustum_planes[i].xyz, cluster.sphere.xyz) + frustum_planes[i].w < -cluster.sphere.w)\n"
+    "            visible = false;\n"
+    "    }\n"
+    "    if (!visible)\n"
+    "    {\n"
+    "        atomicAdd(nb_frustum_culled, 1u);\n"
+    "    }\n"
+    "    else if (cone_culling)\n"
+    "    {\n"
+    "        vec3 view = cluster.sphere.xyz - eye_position;\n"
+    "        if (dot(view, cluster.cone.xyz) >= cluster.cone.w * length(view) + cluster.sphere.w)\n"
+    "        {\n"
+    "            visible = false;\n"
+    "            atomicAdd(nb_cone_culled, 1u);\n"
+    "        }\n"
+    "    }\n"
+    "    commands[cluster_id] = DrawCommand(cluster.nb_indices, visible ? 1u : 0u, cluster.first_index, 0u, 0u);\n"
+    "}\n";
 
 ////////////////////////////////////////////////////////////////////////
-int main(int, char**)
+int main(int argc, char** argv)
 {
     std::cout << "X--------------------------------------------------X" << std::endl;
     std::cout << "|                   GlBench v1.0                   |" << std::endl;
@@ -62,85 +323,299 @@ int main(int, char**)
     display_config.windows_height = 600;
     display_config.rotation_angle_y = default_rotation_angle_y;
     display_config.rotation_angle_x = default_rotation_angle_x;
-    display_config.move_forward = -1.5;
+    display_config.move_forward = default_move_forward;
     display_config.rotation = true;
+    display_config.camera_mode = TIMED_CAMERA;
+    display_config.swap_control = DRIVER_SWAP_INTERVAL;
+    display_config.latency_measure = false;
+    display_config.trace = false;
 
     // Default rendering config
     struct RenderingConfig rendering_config;
     rendering_config.rendering_method = CALL_LIST;
     rendering_config.nb_triangles = 320000;
+    rendering_config.call_list_build = REPLAY_CALL_LIST;
     rendering_config.rendering_options.reset();
     rendering_config.rendering_options.set(TRIANGLE_STRIP);
     rendering_config.rendering_options.set(COLOR);
     rendering_config.rendering_options.set(SMOOTH_SHADING);
     rendering_config.rendering_options.set(BACK_FACE_PAINTING);
+    rendering_config.rendering_options.set(LOCAL_VIEWER);
+    rendering_config.texture_size = TEXTURE_SIZES[0];
+    rendering_config.texture_format = TEXTURE_RGBA8;
+    rendering_config.texture_filter = TEXTURE_NEAREST;
+    rendering_config.readback_mode = NO_READBACK;
+    rendering_config.readback_format = READBACK_RGBA8;
+    rendering_config.framebuffer_width = 0;
+    rendering_config.framebuffer_height = 0;
+    rendering_config.nb_overdraw_passes = 1;
+    rendering_config.nb_samples = 1;
+    rendering_config.depth_format = DEPTH_24;
+    rendering_config.nb_lights = 1;
+    rendering_config.light_type = DIRECTIONAL_LIGHT;
+    rendering_config.nb_scene_objects = 1;
+
+    // Default bench config
+    struct BenchConfig bench_config;
+    bench_config.bench_type = RENDERING_BENCH;
+    bench_config.min_frames = NB_MIN_FRAME;
+    bench_config.max_frames = MAX_SAMPLING_FRAMES;
+    bench_config.target_precision = SAMPLING_TARGET_PRECISION;
+    bench_config.time_budget = BENCH_TIME_BUDGET;
+    bench_config.resume = false;
+    bench_config.shard_id = 1;
+    bench_config.nb_shards = 1;
+
+    // Command line : a bench run without interaction, resumed or sharded, or the merge of the shard reports
+    bool command_line_bench = false;
+    unsigned int nb_merged_shards = 0;
+    if (!parse_command_line(argc, argv, bench_config, command_line_bench, nb_merged_shards))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (nb_merged_shards)
+    {
+        return merge_bench_reports(bench_config, nb_merged_shards) ? 0 : 1;
+    }
 
     // Default rendering data
     struct RenderingData rendering_data;
-    rendering_data.texture_id = 0;
-    rendering_data.call_list_id = 0;
-    rendering_data.index_buffer_id  = 0;
-    rendering_data.vertex_buffer_id = 0;
-
-    // Initialization
+    init_rendering_data(rendering_data, display_config);
+
+    trace_data.enabled = false;
+    trace_data.nb_dropped_events = 0;
+    trace_data.gpu_start_time = 0;
+    trace_data.first_pending_query = 0;
+    trace_data.nb_pending_queries = 0;
+    trace_data.gpu_frame_open = false;
+
+    // Initialization, Xlib is used by the rendering threads of the thread scaling bench
+    XInitThreads();
+    reset_peak_rss();
     init_sdl(display_config);
     init_gl_extensions();
     generate_model(rendering_config, rendering_data);
     init_gl(rendering_data, display_config, rendering_config);
     print_config(rendering_config, std::cout);
+    print_display_config(display_config, std::cout);
 
     std::deque<long> rendering_times;
     bool first_frame = true;
 
+    FramePacing frame_pacing;
+    clear_frame_pacing(frame_pacing);
+
     EventType event_type = NO_EVENT;
 
     // Bench
     bool bench_mode = false;
     std::deque<RenderingConfig> bench_rendering_config_list;
+    std::deque<BenchResult> bench_results;
     std::ofstream   bench_stream;
+    std::ostringstream bench_record;        // results of the current config, appended whole to the report
+    std::string     bench_report;
+    std::deque<unsigned int> bench_config_ids;  // of each config left, in the whole matrix
+    unsigned int    bench_matrix_size = 0;
     unsigned int    bench_rendering_config_nb = 0;
+    bool command_line_bench_pending = command_line_bench;
+    bool validation_failed = false;         // exit status of a validation run from the command line
     bool exit_bench = false;
+    struct timeval bench_start_time;
+    struct timeval config_start_time;
+    long config_time_budget = 0;            // us of wall clock time for the current config
+    SamplingState sampling = SAMPLING;
 
     // Current config
     RenderingConfig* p_current_rendering_config = &rendering_config;
     std::ostream*    p_current_stream = &std::cout;
 
+    struct timeval input_time;
     struct timeval start;
     struct timeval end;
+    struct timeval present_time;
+
+    unsigned int camera_frame_id = 0;
 
     do // Main loop
     {
+        gettimeofday(&input_time, NULL);
+
         // Event handler function
-        event_type = event_sdl(display_config, rendering_config);
+        {
+            ScopedTrace trace("event_sdl");
+            event_type = event_sdl(display_config, rendering_config, bench_config);
+        }
+        if (command_line_bench_pending)
+        {
+            event_type = BENCH_REQUESTED;
+            command_line_bench_pending = false;
+        }
 
         if (!bench_mode &&  event_type == RENDERING_CONFIG_CHANGED)
         {
+            ScopedTrace trace("config switch");
             first_frame = true;
+            reset_peak_rss();
             generate_model(rendering_config, rendering_data);
             init_gl(rendering_data, display_config, rendering_config);
             rendering_times.clear();
             print_config(rendering_config, *p_current_stream);
         }
+        else if (!bench_mode && event_type == BENCH_CONFIG_CHANGED)
+        {
+            print_bench_config(bench_config, *p_current_stream);
+        }
+        else if (event_type == DISPLAY_CONFIG_CHANGED)
+        {
+            set_swap_interval(display_config.swap_control);
+            if (display_config.trace && !trace_data.enabled)
+            {
+                start_trace(trace_data);
+            }
+            else if (!display_config.trace && trace_data.enabled)
+            {
+                stop_trace(trace_data, TRACE_FILE);
+            }
+            print_display_config(display_config, std::cout);
+            clear_frame_pacing(frame_pacing);
+        }
         else if (event_type == BENCH_REQUESTED)
         {
             rendering_times.clear();
-            if (bench_mode == false) //enter in bench mode
+            if (bench_mode == false && bench_config.bench_type == TEXTURE_UPLOAD_BENCH) // one shot bench, out of the main loop
+            {
+                std::cout << std::endl << "X--------------------------------------------------X" << std::endl;
+                std::cout << "| Texture upload bench started " << std::flush;
+
+                bench_stream.open(TEXTURE_BENCH_FILE);
+                bench_texture_upload(bench_stream);
+                bench_stream.close();
+
+                std::cout << std::endl << "| Bench exit ";
+
+                // The bench leaves its own texture state, restore the current one
+                first_frame = true;
+                print_config(rendering_config, *p_current_stream);
+                init_gl(rendering_data, display_config, rendering_config);
+            }
+            else if (bench_mode == false && bench_config.bench_type == THREAD_SCALING_BENCH) // one shot bench, out of the main loop
+            {
+                std::cout << std::endl << "X--------------------------------------------------X" << std::endl;
+                std::cout << "| Thread scaling bench started " << std::flush;
+
+                bench_stream.open(THREAD_BENCH_FILE);
+                print_config(rendering_config, bench_stream);
+                bench_thread_scaling(bench_stream, rendering_data, display_config, rendering_config);
+                bench_stream.close();
+
+                std::cout << std::endl << "| Bench exit ";
+                first_frame = true;
+            }
+            else if (bench_mode == false && bench_config.bench_type == VALIDATION_BENCH) // one shot bench, out of the main loop
+            {
+                std::cout << std::endl << "X--------------------------------------------------X" << std::endl;
+                std::cout << "| Validation bench started " << std::flush;
+
+                bench_stream.open(VALIDATION_BENCH_FILE);
+                const bool valid = bench_validation(bench_stream, rendering_data, display_config, rendering_config);
+                bench_stream.close();
+                validation_failed = validation_failed || !valid;
+
+                std::cout << std::endl << "| Validation " << (valid ? "passed" : "FAILED, see ") << (valid ? "" : VALIDATION_BENCH_FILE);
+                std::cout << std::endl << "| Bench exit ";
+
+                // The bench renders its own configs, restore the current one
+                first_frame = true;
+                print_config(rendering_config, *p_current_stream);
+                init_gl(rendering_data, display_config, rendering_config);
+            }
+            else if (bench_mode == false) //enter in bench mode
             {
                 bench_mode = true;
-                generate_bench_rendering_config_list(bench_rendering_config_list, rendering_config.nb_triangles);
+                if (bench_config.bench_type == READBACK_BENCH)
+                {
+                    generate_readback_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == FILL_RATE_BENCH)
+                {
+                    generate_fill_rate_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == SCENE_BENCH)
+                {
+                    generate_scene_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == CALL_LIST_BENCH)
+                {
+                    generate_call_list_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == STREAMING_BENCH)
+                {
+                    generate_streaming_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == PROCEDURAL_BENCH)
+                {
+                    generate_procedural_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == GPU_CULLING_BENCH)
+                {
+                    generate_gpu_culling_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == MULTISAMPLE_BENCH)
+                {
+                    generate_multisample_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else if (bench_config.bench_type == LIGHTING_BENCH)
+                {
+                    generate_lighting_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                else
+                {
+                    generate_bench_rendering_config_list(bench_rendering_config_list, rendering_config);
+                }
+                // Configs of other shards and configs already in the resumed report are left out
+                bench_matrix_size = bench_rendering_config_list.size();
+                const std::string matrix_line = bench_matrix_line(bench_rendering_config_list);
+                bench_report = bench_report_name(bench_config);
+                bench_results.clear();
+                const bool report_has_header = prepare_bench_report(bench_report, bench_config, bench_rendering_config_list, bench_config_ids, bench_results);
                 bench_rendering_config_nb = bench_rendering_config_list.size();
-
-                p_current_rendering_config = &bench_rendering_config_list.front();
+                gettimeofday(&bench_start_time, NULL);
 
                 display_config.rotation = false;
                 display_config.rotation_angle_x = default_rotation_angle_x;
                 display_config.rotation_angle_y = default_rotation_angle_y;
 
-                bench_stream.open(BENCH_FILE);
-                p_current_stream = &bench_stream;
+                p_current_stream = &bench_record;
+                bench_record.str("");
+                if (!report_has_header)
+                {
+                    print_display_config(display_config, *p_current_stream);
+                    (*p_current_stream) << matrix_line << std::endl;
+                    // Results of different drivers (Mesa or vendor) on the same GPU are told apart by the renderer
+                    (*p_current_stream) << bench_renderer_line() << std::endl;
+                }
 
                 std::cout << std::endl << "X--------------------------------------------------X" << std::endl;
-                std::cout << "| Bench started " << std::endl;
+                std::cout << "| Bench started : " << bench_rendering_config_nb << " of " << bench_matrix_size << " configs to " << bench_report << std::endl;
+
+                if (bench_rendering_config_list.empty())
+                {
+                    exit_bench = true;
+                }
+                else
+                {
+                    p_current_rendering_config = &bench_rendering_config_list.front();
+                    bench_record << bench_config_line("started", bench_config_ids.front(), bench_matrix_size, *p_current_rendering_config) << std::endl;
+                    append_bench_report(bench_report, bench_record.str());
+                    bench_record.str("");
+
+                    gettimeofday(&config_start_time, NULL);
+                    config_time_budget = bench_config_time_budget(bench_config, bench_start_time, config_start_time, bench_rendering_config_list.size());
+                    first_frame = true;
+                    reset_peak_rss();
+                    init_gl(rendering_data, display_config, *p_current_rendering_config);
+                }
             }
             else // leave it
             {
@@ -148,17 +623,58 @@ int main(int, char**)
             }
         }
 
-        if (bench_mode && rendering_times.size() == NB_MIN_FRAME)
+        // Each config is sampled until its median converges, or its share of the time budget is spent
+        sampling = SAMPLING;
+        if (bench_mode && !bench_rendering_config_list.empty())
+        {
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            sampling = sampling_state(rendering_times, bench_config.min_frames, bench_config.max_frames, bench_config.target_precision,
+                                      elapsed_time_us(config_start_time, now), config_time_budget);
+        }
+
+        if (bench_mode && sampling != SAMPLING)
         {
             //print bench results
             print_config(*p_current_rendering_config, (*p_current_stream));
-            print_rendering_time (*p_current_stream, p_current_rendering_config->nb_triangles, rendering_times);
-
+            print_rendering_time (*p_current_stream, frame_nb_triangles(*p_current_rendering_config), frame_nb_pixels(rendering_data, *p_current_rendering_config), rendering_times);
+            print_sampling(*p_current_stream, rendering_times, sampling);
+            print_scene_stats(*p_current_stream, rendering_data, rendering_times);
+            print_streaming_stats(*p_current_stream, rendering_data.streaming, rendering_times);
+            print_culling_stats(*p_current_stream, rendering_data.culling);
+            print_multisample_times(*p_current_stream, rendering_data.multisample);
+            print_readback_time(*p_current_stream, rendering_data.readback, *p_current_rendering_config);
+            print_frame_pacing(*p_current_stream, frame_pacing);
+            GL_COUNTERS_PRINT(*p_current_stream);
+            print_setup_times(*p_current_stream, rendering_data.setup_times);
+            print_memory_usage(*p_current_stream, rendering_data);
+
+            BenchResult bench_result;
+            bench_result.rendering_config = *p_current_rendering_config;
+            bench_result.rendering_width = rendering_data.rendering_width;
+            bench_result.rendering_height = rendering_data.rendering_height;
+            bench_result.mean_rendering_time = mean_time(rendering_times);
+            bench_results.push_back(bench_result);
+
+            // The config is in the report once its closing line is
+            (*p_current_stream) << std::endl << bench_config_line("config", bench_config_ids.front(), bench_matrix_size, *p_current_rendering_config) << " : ";
+            print_fixed(*p_current_stream, bench_result.mean_rendering_time, 1);
+            (*p_current_stream) << " us, " << bench_result.rendering_width << "x" << bench_result.rendering_height << std::endl;
+            append_bench_report(bench_report, bench_record.str());
+            bench_record.str("");
+
+            ScopedTrace trace("config switch");
             rendering_times.clear();
             bench_rendering_config_list.pop_front();
+            bench_config_ids.pop_front();
             if (!bench_rendering_config_list.empty())
             {
                 p_current_rendering_config = &bench_rendering_config_list.front();
+                append_bench_report(bench_report, bench_config_line("started", bench_config_ids.front(), bench_matrix_size, *p_current_rendering_config) + "\n");
+                gettimeofday(&config_start_time, NULL);
+                config_time_budget = bench_config_time_budget(bench_config, bench_start_time, config_start_time, bench_rendering_config_list.size());
+                first_frame = true;
+                reset_peak_rss();
                 init_gl(rendering_data, display_config, *p_current_rendering_config);
             }
             else
@@ -175,34 +691,95 @@ int main(int, char**)
 
             std::cout << std::endl << "| Bench exit ";
 
+            // A config left by the user is not an attempt, a resumed run starts it again
+            if (!bench_rendering_config_list.empty())
+            {
+                bench_record << bench_config_line("aborted", bench_config_ids.front(), bench_matrix_size, bench_rendering_config_list.front()) << std::endl;
+            }
+
             p_current_rendering_config = &rendering_config;
             display_config.rotation = true;
 
-            bench_stream.close();
+            // Resumed runs sum up the configs of the previous runs too
+            print_bench_summary(*p_current_stream, bench_config.bench_type, bench_results);
+            (*p_current_stream) << BENCH_END_LINE << std::endl;
+            append_bench_report(bench_report, bench_record.str());
+            bench_record.str("");
+            bench_rendering_config_list.clear();
+            bench_config_ids.clear();
             p_current_stream = &std::cout;
 
             print_config(*p_current_rendering_config, (*p_current_stream));
+            first_frame = true;
             init_gl(rendering_data, display_config, *p_current_rendering_config);
          }
 
+        // Deterministic cameras restart their path with each config, so that every config renders the same frames
+        if (first_frame)
+        {
+            camera_frame_id = 0;
+        }
+        if (display_config.camera_mode != TIMED_CAMERA)
+        {
+            set_camera(display_config, camera_frame_id);
+        }
+
         gettimeofday(&start, NULL);
+        begin_gpu_trace_frame(trace_data);
 
         // Render function
         render(rendering_data, *p_current_rendering_config, display_config);
 
+        // Read the frame back before it is presented
+        readback_frame(rendering_data, *p_current_rendering_config);
+
+        end_gpu_trace_frame(trace_data);
+        {
+            ScopedTrace trace("swap");
+            glFlush();
+            SDL_GL_SwapBuffers();
+        }
+
         gettimeofday(&end, NULL);
 
+        // Wait for the end of the frame, out of the rendering time, to estimate when it is presented
+        present_time = end;
+        if (display_config.latency_measure)
+        {
+            ScopedTrace trace("glFinish");
+            glFinish();
+            gettimeofday(&present_time, NULL);
+        }
+
         // First frame is longer to process, skip it fir the time benchmarking
         if (first_frame)
         {
+            rendering_data.setup_times.first_frame = elapsed_time_us(start, end);
+            if (!bench_mode)
+            {
+                print_setup_times(*p_current_stream, rendering_data.setup_times);
+                print_memory_usage(*p_current_stream, rendering_data);
+                (*p_current_stream) << std::endl;
+            }
+
             rendering_times.clear();
+            rendering_data.readback.readback_times.clear();
+            clear_streaming_stats(rendering_data.streaming);
+            clear_culling_stats(rendering_data.culling);
+            clear_multisample_stats(rendering_data.multisample);
+            clear_frame_pacing(frame_pacing);
+            GL_COUNTERS_END_SETUP();
+            update_frame_pacing(frame_pacing, input_time, present_time);
             first_frame = false;
         }
         else
         {
-            long current_rendering_time = elapsed_time(start, end);
+            long current_rendering_time = elapsed_time_us(start, end);
+            update_frame_pacing(frame_pacing, input_time, present_time);
+            GL_COUNTERS_END_FRAME();
 
-            if (rendering_times.size() >= NB_MIN_FRAME)
+            // The bench keeps every sample of the config, the interactive display a sliding window
+            if (rendering_times.size() >= (bench_mode ? bench_config.max_frames : NB_MIN_FRAME))
             {
                 rendering_times.pop_back();
             }
@@ -212,627 +789,3737 @@ int main(int, char**)
             if (!bench_mode)
             {
                 (*p_current_stream) << "\r";
-                print_rendering_time (*p_current_stream, p_current_rendering_config->nb_triangles, rendering_times);
+                print_rendering_time (*p_current_stream, frame_nb_triangles(*p_current_rendering_config), frame_nb_pixels(rendering_data, *p_current_rendering_config), rendering_times);
+                print_scene_stats(*p_current_stream, rendering_data, rendering_times);
+                print_streaming_stats(*p_current_stream, rendering_data.streaming, rendering_times);
+                print_culling_stats(*p_current_stream, rendering_data.culling);
+                print_multisample_times(*p_current_stream, rendering_data.multisample);
+                print_readback_time(*p_current_stream, rendering_data.readback, *p_current_rendering_config);
+                print_frame_pacing(*p_current_stream, frame_pacing);
+                GL_COUNTERS_PRINT(*p_current_stream);
             }
 
-            if (display_config.rotation)
+            if (display_config.rotation && display_config.camera_mode == TIMED_CAMERA)
             {
-                display_config.rotation_angle_y += 0.02 * current_rendering_time;
+                display_config.rotation_angle_y += 0.00002 * current_rendering_time;
             }
         }
 
+        // The bench stops the timed rotation only
+        if (display_config.rotation || bench_mode)
+        {
+            ++camera_frame_id;
+        }
+
         GLenum error = glGetError();
         if (error != GL_NO_ERROR)
         {
             std::cout << "Warning : Opengl error (" << error << ")" << std::endl;
         }
 
+        // A bench run from the command line quits once done
+        if (command_line_bench && !bench_mode)
+        {
+            event_type = QUIT_REQUESTED;
+        }
+
     } while (event_type != QUIT_REQUESTED);
 
     std::cout << std::endl;
 
+    // Quit in the middle of a bench, the results of the config are dropped but it does not count as an attempt
+    if (bench_mode && !bench_rendering_config_list.empty())
+    {
+        append_bench_report(bench_report, bench_config_line("aborted", bench_config_ids.front(), bench_matrix_size, bench_rendering_config_list.front()) + "\n");
+    }
+
+    if (trace_data.enabled)
+    {
+        stop_trace(trace_data, TRACE_FILE);
+    }
+
     delete_call_list(rendering_data);
     delete_vbo(rendering_data);
+    delete_streaming(rendering_data);
+    delete_procedural(rendering_data);
+    delete_culling(rendering_data);
+    delete_readback(rendering_data);
+    delete_framebuffer(rendering_data);
 
     SDL_Quit();
+
+    // Scripts running the validation bench see its result
+    return (command_line_bench && validation_failed) ? 1 : 0;
 }
 
 ////////////////////////////////////////////////////////////////////////
-long elapsed_time(const struct timeval& in_start, const struct timeval& in_end)
+bool parse_command_line(int argc, char** argv, BenchConfig& io_bench_config, bool& out_command_line_bench, unsigned int& out_nb_merged_shards)
 {
-    long seconds  = in_end.tv_sec  - in_start.tv_sec;
-    long useconds = in_end.tv_usec - in_start.tv_usec;
-    return seconds * 1000 + static_cast<long>(static_cast<double>(useconds) / 1000.0 + 0.5);
+    out_command_line_bench = false;
+    out_nb_merged_shards = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--bench" && i + 1 < argc)
+        {
+            if (!bench_type_from_file_name(argv[++i], io_bench_config.bench_type))
+            {
+                std::cout << "Unknown bench report : " << argv[i] << std::endl;
+                return false;
+            }
+            out_command_line_bench = true;
+        }
+        else if (argument == "--resume")
+        {
+            io_bench_config.resume = true;
+        }
+        else if (argument == "--shard" && i + 1 < argc)
+        {
+            unsigned int shard_id = 0;
+            unsigned int nb_shards = 0;
+            if (sscanf(argv[++i], "%u/%u", &shard_id, &nb_shards) != 2 || shard_id < 1 || shard_id > nb_shards)
+            {
+                std::cout << "Invalid shard : " << argv[i] << std::endl;
+                return false;
+            }
+            io_bench_config.shard_id = shard_id;
+            io_bench_config.nb_shards = nb_shards;
+        }
+        else if (argument == "--merge" && i + 1 < argc)
+        {
+            if (sscanf(argv[++i], "%u", &out_nb_merged_shards) != 1 || out_nb_merged_shards < 2)
+            {
+                std::cout << "Invalid number of shards : " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else
+        {
+            std::cout << "Unknown argument : " << argument << std::endl;
+            return false;
+        }
+    }
+
+    if (out_nb_merged_shards && !out_command_line_bench)
+    {
+        std::cout << "--merge needs the report of the bench (--bench)" << std::endl;
+        return false;
+    }
+    if (out_nb_merged_shards && is_one_shot_bench(io_bench_config.bench_type))
+    {
+        std::cout << bench_file_name(io_bench_config.bench_type) << " has no config matrix to merge" << std::endl;
+        return false;
+    }
+    if (is_one_shot_bench(io_bench_config.bench_type) && (io_bench_config.resume || io_bench_config.nb_shards > 1))
+    {
+        std::cout << "Warning : " << bench_file_name(io_bench_config.bench_type) << " is not resumed nor sharded" << std::endl;
+    }
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////
-void init_sdl(const DisplayConfig& in_display_config)
+void print_usage(const char* in_program_name)
 {
-    SDL_Init(SDL_INIT_VIDEO);
-
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_WM_SetCaption("GlBench", NULL);
+    std::cout << "Usage : " << in_program_name << " [--bench <report>] [--resume] [--shard <i>/<n>]" << std::endl;
+    std::cout << "        " << in_program_name << " --bench <report> --merge <n>" << std::endl;
+    std::cout << " --bench <report>  run the bench of this report (bench.txt, fill_rate_bench.txt...) then quit" << std::endl;
+    std::cout << " --resume          skip the configs already in the report, append the others" << std::endl;
+    std::cout << " --shard <i>/<n>   run the i-th of n interleaved parts of the config matrix, into <report>.<i>of<n>.txt" << std::endl;
+    std::cout << " --merge <n>       merge the reports of the n shards into the report" << std::endl;
+}
 
-    SDL_SetVideoMode(in_display_config.windows_width, in_display_config.windows_height, 32, SDL_OPENGL | SDL_GL_DOUBLEBUFFER);
+////////////////////////////////////////////////////////////////////////
+std::string bench_renderer_line()
+{
+    return BENCH_RENDERER_LINE + reinterpret_cast<const char*>(glGetString(GL_RENDERER)) + ", " + reinterpret_cast<const char*>(glGetString(GL_VERSION));
 }
 
 ////////////////////////////////////////////////////////////////////////
-void init_gl_extensions()
+std::string bench_matrix_line(const std::deque<RenderingConfig>& in_rendering_config_list)
 {
-    const unsigned char *exts = glGetString(GL_EXTENSIONS);
-    if (strstr(reinterpret_cast<const char*>(exts), "GL_ARB_vertex_buffer_object") == NULL)
-    {
-        std::cout << "Warning : VBO extension is not supported by our graphic card" << std::endl;
-    }
-    else
+    // FNV-1a of the keys of every config : resumed runs and shards are checked against the whole matrix
+    unsigned int fingerprint = 2166136261U;
+    for (std::deque<RenderingConfig>::const_iterator it = in_rendering_config_list.begin(); it != in_rendering_config_list.end(); ++it)
     {
-        glGenBuffers    = reinterpret_cast<PFNGLGENBUFFERSPROC>   (SDL_GL_GetProcAddress("glGenBuffers"));
-        glBindBuffer    = reinterpret_cast<PFNGLBINDBUFFERPROC>   (SDL_GL_GetProcAddress("glBindBuffer"));
-        glBufferData    = reinterpret_cast<PFNGLBUFFERDATAPROC>   (SDL_GL_GetProcAddress("glBufferData"));
-        glDeleteBuffers = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteBuffers"));
+        const std::string key = rendering_config_key(*it) + "\n";
+        for (std::string::const_iterator c = key.begin(); c != key.end(); ++c)
+        {
+            fingerprint = (fingerprint ^ static_cast<unsigned char>(*c)) * 16777619U;
+        }
     }
+    std::ostringstream line_stream;
+    line_stream << BENCH_MATRIX_LINE << in_rendering_config_list.size() << " configs, fingerprint " << std::hex << std::setw(8) << std::setfill('0') << fingerprint;
+    return line_stream.str();
 }
 
 ////////////////////////////////////////////////////////////////////////
-void init_gl(RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config)
+std::string bench_config_line(const char* in_tag, unsigned int in_config_id, unsigned int in_nb_configs, const RenderingConfig& in_rendering_config)
 {
-    glViewport(0 , 0, static_cast<GLsizei>(in_display_config.windows_width), static_cast<GLsizei>(in_display_config.windows_height));
+    std::ostringstream line_stream;
+    line_stream << "| " << in_tag << " " << in_config_id + 1 << "/" << in_nb_configs << " : " << rendering_config_key(in_rendering_config);
+    return line_stream.str();
+}
 
-    if (in_rendering_config.rendering_options.test(WIREFRAME))
+////////////////////////////////////////////////////////////////////////
+bool append_bench_report(const std::string& in_file_name, const std::string& in_text)
+{
+    // A single write at the end of the file, synced : a crash afterwards leaves the text whole in the report
+    const int file_descriptor = open(in_file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    bool success = (file_descriptor >= 0);
+    size_t written_size = 0;
+    while (success && written_size < in_text.size())
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        const ssize_t result = write(file_descriptor, in_text.data() + written_size, in_text.size() - written_size);
+        success = (result > 0);
+        written_size += success ? result : 0;
     }
-    else
+    if (file_descriptor >= 0)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        success = (fsync(file_descriptor) == 0) && success;
+        close(file_descriptor);
     }
+    if (!success)
+    {
+        std::cout << "Warning : can not append to " << in_file_name << std::endl;
+    }
+    return success;
+}
 
-    glEnable(GL_DEPTH_TEST);                // Enable Z-buffer for visibility
-    glEnable(GL_LIGHTING);
-    glEnable(GL_LIGHT0);
-    glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
-
-    glEnable(GL_COLOR_MATERIAL);
-
-    // Back face painting
-    if (in_rendering_config.rendering_options.test(BACK_FACE_PAINTING))
+////////////////////////////////////////////////////////////////////////
+bool write_bench_report(const std::string& in_file_name, const BenchReport& in_bench_report)
+{
+    // Written aside then renamed, the previous report stays whole until the new one replaces it
+    const std::string temporary_file_name = in_file_name + ".tmp";
+    std::ofstream report_stream(temporary_file_name.c_str());
+    report_stream << in_bench_report.header;
+    std::map<unsigned int, bool> recorded_config_ids;
+    for (std::vector<BenchRecord>::const_iterator it = in_bench_report.records.begin(); it != in_bench_report.records.end(); ++it)
     {
-        glDisable(GL_CULL_FACE);
-        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+        report_stream << (*it).text;
+        recorded_config_ids[(*it).config_id] = true;
     }
-    else
+    // Attempts of the configs without a result are kept for the next resume
+    for (std::map<unsigned int, std::string>::const_iterator it = in_bench_report.started_lines.begin(); it != in_bench_report.started_lines.end(); ++it)
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
-        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
+        if (!recorded_config_ids.count((*it).first))
+        {
+            const unsigned int nb_started = in_bench_report.nb_started.find((*it).first)->second;
+            for (unsigned int i = 0; i < nb_started; ++i)
+            {
+                report_stream << (*it).second << std::endl;
+            }
+        }
     }
+    report_stream.close();
 
-    // Texturing
-    if (in_rendering_config.rendering_options.test(TEXTURE))
+    if (report_stream.fail() || rename(temporary_file_name.c_str(), in_file_name.c_str()) != 0)
     {
-        glEnable(GL_TEXTURE_2D);
+        std::cout << "Warning : can not write " << in_file_name << std::endl;
+        return false;
     }
-    else
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+bool read_bench_report(const std::string& in_file_name, BenchReport& out_bench_report)
+{
+    std::ifstream report_stream(in_file_name.c_str());
+    if (!report_stream)
     {
-        glDisable(GL_TEXTURE_2D);
+        return false;
     }
 
-    // Smooth shading
-    glShadeModel(in_rendering_config.rendering_options.test(SMOOTH_SHADING) ? GL_SMOOTH : GL_FLAT);
+    bool header_read = false;
+    std::string text;                       // lines of the config being read
+    std::string line;
+    while (std::getline(report_stream, line))
+    {
+        unsigned int config_number = 0;
+        unsigned int nb_configs = 0;
+        if (!header_read)
+        {
+            out_bench_report.header += line + "\n";
+            if (line.compare(0, BENCH_MATRIX_LINE.size(), BENCH_MATRIX_LINE) == 0)
+            {
+                out_bench_report.matrix = line;
+            }
+            header_read = (line.compare(0, BENCH_RENDERER_LINE.size(), BENCH_RENDERER_LINE) == 0);
+            out_bench_report.renderer = header_read ? line : "";
+        }
+        else if (sscanf(line.c_str(), "| started %u/%u", &config_number, &nb_configs) == 2 && config_number >= 1)
+        {
+            // Lines left by a config cut short are dropped, attempts of another config with the same number are forgotten
+            const std::map<unsigned int, std::string>::const_iterator started_it = out_bench_report.started_lines.find(config_number - 1);
+            if (started_it != out_bench_report.started_lines.end() && (*started_it).second != line)
+            {
+                out_bench_report.nb_started[config_number - 1] = 0;
+            }
+            ++out_bench_report.nb_started[config_number - 1];
+            out_bench_report.started_lines[config_number - 1] = line;
+            text.clear();
+        }
+        else if (sscanf(line.c_str(), "| aborted %u/%u", &config_number, &nb_configs) == 2 && config_number >= 1)
+        {
+            // Stopped by the user : only runs that died count as attempts
+            out_bench_report.nb_started.erase(config_number - 1);
+            out_bench_report.started_lines.erase(config_number - 1);
+            text.clear();
+        }
+        else if (sscanf(line.c_str(), "| config %u/%u", &config_number, &nb_configs) == 2 && config_number >= 1)
+        {
+            // | config <number>/<nb_configs> : <key> : <mean frame time> us, <width>x<height>, or skipped
+            const size_t key_begin = line.find(" : ");
+            const size_t key_end = (key_begin == std::string::npos) ? std::string::npos : line.find(" : ", key_begin + 3);
+            if (key_end != std::string::npos)
+            {
+                BenchRecord record;
+                record.config_id = config_number - 1;
+                record.nb_configs = nb_configs;
+                record.key = line.substr(key_begin + 3, key_end - key_begin - 3);
+                record.result.mean_rendering_time = 0.0;
+                record.result.rendering_width = 0;
+                record.result.rendering_height = 0;
+                record.completed = parse_rendering_config_key(record.key, record.result.rendering_config)
+                                   && sscanf(line.c_str() + key_end + 3, "%lf us, %ux%u", &record.result.mean_rendering_time,
+                                             &record.result.rendering_width, &record.result.rendering_height) == 3;
+                record.text = text + line + "\n";
+                out_bench_report.records.push_back(record);
+            }
+            text.clear();
+        }
+        else if (line.compare(0, BENCH_END_LINE.size(), BENCH_END_LINE) == 0)
+        {
+            text.clear();                   // summary of the run, written again at the end of the next one
+        }
+        else
+        {
+            text += line + "\n";
+        }
+    }
 
-    process_texturing(io_rendering_data, in_rendering_config);
-    process_call_list(io_rendering_data, in_rendering_config);
-    process_vbo(io_rendering_data, in_rendering_config);
+    if (!header_read)
+    {
+        out_bench_report.header.clear();
+    }
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////
-EventType event_sdl(DisplayConfig& io_display_config, RenderingConfig& io_rendering_config)
+bool prepare_bench_report(const std::string& in_file_name, const BenchConfig& in_bench_config, std::deque<RenderingConfig>& io_rendering_config_list,
+                          std::deque<unsigned int>& out_config_ids, std::deque<BenchResult>& out_bench_results)
 {
-    static int mouse_current_position_x = -1;
-    static int mouse_current_position_y = -1;
-    static bool mouse_left_button_down = false;
-
-    EventType event_type = NO_EVENT;
-
-    SDL_PumpEvents();                       // load all the events
+    const unsigned int nb_configs = io_rendering_config_list.size();
 
-    SDL_Event event;
+    // A resumed report must come from the same config matrix
+    BenchReport bench_report;
+    if (in_bench_config.resume && read_bench_report(in_file_name, bench_report))
+    {
+        bool same_matrix = bench_report.matrix.empty() || bench_report.matrix == bench_matrix_line(io_rendering_config_list);
+        for (std::vector<BenchRecord>::const_iterator it = bench_report.records.begin(); same_matrix && it != bench_report.records.end(); ++it)
+        {
+            same_matrix = (*it).nb_configs == nb_configs && (*it).config_id < nb_configs && (*it).key == rendering_config_key(io_rendering_config_list[(*it).config_id]);
+        }
+        if (!same_matrix)
+        {
+            std::cout << "Warning : " << in_file_name << " comes from other configs, the bench starts over" << std::endl;
+            bench_report = BenchReport();
+        }
+
+        // Attempts only count for the config they were started with : | started <number>/<nb_configs> : <key>
+        std::map<unsigned int, std::string>::iterator it = bench_report.started_lines.begin();
+        while (it != bench_report.started_lines.end())
+        {
+            const std::string& line = (*it).second;
+            unsigned int config_number = 0;
+            unsigned int started_nb_configs = 0;
+            const size_t key_begin = line.find(" : ");
+            const bool same_config = sscanf(line.c_str(), "| started %u/%u", &config_number, &started_nb_configs) == 2
+                                     && started_nb_configs == nb_configs && (*it).first < nb_configs && key_begin != std::string::npos
+                                     && line.substr(key_begin + 3) == rendering_config_key(io_rendering_config_list[(*it).first]);
+            if (same_config)
+            {
+                ++it;
+            }
+            else
+            {
+                bench_report.nb_started.erase((*it).first);
+                bench_report.started_lines.erase(it++);
+            }
+        }
+        // Results of another driver or GPU are not mixed with the ones of the current renderer
+        if (!bench_report.renderer.empty() && bench_report.renderer != bench_renderer_line())
+        {
+            std::cout << "Warning : " << in_file_name << " comes from another renderer, the bench starts over" << std::endl;
+            bench_report = BenchReport();
+        }
+    }
+
+    // Rewritten with the whole configs only, or emptied when the bench is not resumed
+    write_bench_report(in_file_name, bench_report);
+
+    std::map<unsigned int, bool> done_config_ids;
+    for (std::vector<BenchRecord>::const_iterator it = bench_report.records.begin(); it != bench_report.records.end(); ++it)
+    {
+        done_config_ids[(*it).config_id] = true;
+        if ((*it).completed)
+        {
+            out_bench_results.push_back((*it).result);
+        }
+    }
+
+    std::deque<RenderingConfig> rendering_config_list;
+    out_config_ids.clear();
+    std::ostringstream skipped_stream;
+    for (unsigned int config_id = 0; config_id < nb_configs; ++config_id)
+    {
+        if (config_id % in_bench_config.nb_shards != in_bench_config.shard_id - 1 || done_config_ids.count(config_id))
+        {
+            continue;
+        }
+
+        // A config that crashed every attempt is skipped so that a driver hang does not stop the rest of the matrix
+        const RenderingConfig& rendering_config = io_rendering_config_list[config_id];
+        const unsigned int nb_started = bench_report.nb_started[config_id];
+        if (nb_started >= BENCH_MAX_ATTEMPTS)
+        {
+            print_config(rendering_config, skipped_stream);
+            skipped_stream << "| skipped : started " << nb_started << " times without a result" << std::endl;
+            skipped_stream << bench_config_line("config", config_id, nb_configs, rendering_config) << " : skipped" << std::endl;
+            continue;
+        }
+        rendering_config_list.push_back(rendering_config);
+        out_config_ids.push_back(config_id);
+    }
+    if (!skipped_stream.str().empty())
+    {
+        append_bench_report(in_file_name, skipped_stream.str());
+    }
+
+    io_rendering_config_list.swap(rendering_config_list);
+    return !bench_report.header.empty();
+}
+
+////////////////////////////////////////////////////////////////////////
+long bench_config_time_budget(const BenchConfig& in_bench_config, const struct timeval& in_bench_start_time, const struct timeval& in_config_start_time,
+                              unsigned int in_nb_remaining_configs)
+{
+    // Set once when the config starts : the budget left shared by the configs left, this one included
+    const long remaining_time_budget = std::max(0L, in_bench_config.time_budget * 1000000L - elapsed_time_us(in_bench_start_time, in_config_start_time));
+    return remaining_time_budget / static_cast<long>(std::max(1U, in_nb_remaining_configs));
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_bench_summary(std::ostream& out_stream, BenchType in_bench_type, const std::deque<BenchResult>& in_bench_results)
+{
+    if (in_bench_type == FILL_RATE_BENCH)
+    {
+        print_fill_rate_summary(out_stream, in_bench_results);
+    }
+    else if (in_bench_type == LIGHTING_BENCH)
+    {
+        print_lighting_summary(out_stream, in_bench_results);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+bool merge_bench_reports(const BenchConfig& in_bench_config, unsigned int in_nb_shards)
+{
+    // Records of the shards in the order of the matrix, the last one of a config wins
+    // Shards must come from the same renderer and the same config matrix
+    BenchConfig shard_bench_config = in_bench_config;
+    shard_bench_config.nb_shards = in_nb_shards;
+    BenchReport merged_report;
+    std::map<unsigned int, BenchRecord> records;
+    unsigned int nb_configs = 0;
+    unsigned int nb_read_shards = 0;
+    for (unsigned int shard_id = 1; shard_id <= in_nb_shards; ++shard_id)
+    {
+        shard_bench_config.shard_id = shard_id;
+        const std::string shard_report_name = bench_report_name(shard_bench_config);
+        BenchReport shard_report;
+        if (!read_bench_report(shard_report_name, shard_report))
+        {
+            std::cout << "Warning : " << shard_report_name << " is missing" << std::endl;
+            continue;
+        }
+        ++nb_read_shards;
+        if (merged_report.header.empty())
+        {
+            merged_report.header = shard_report.header;
+            merged_report.matrix = shard_report.matrix;
+            merged_report.renderer = shard_report.renderer;
+        }
+        else if (shard_report.renderer != merged_report.renderer)
+        {
+            std::cout << shard_report_name << " comes from another renderer (" << shard_report.renderer << "), the shards are not merged" << std::endl;
+            return false;
+        }
+        else if (shard_report.matrix != merged_report.matrix)
+        {
+            std::cout << shard_report_name << " comes from another config matrix, the shards are not merged" << std::endl;
+            return false;
+        }
+        for (std::vector<BenchRecord>::const_iterator it = shard_report.records.begin(); it != shard_report.records.end(); ++it)
+        {
+            const std::map<unsigned int, BenchRecord>::const_iterator record_it = records.find((*it).config_id);
+            if ((nb_configs && (*it).nb_configs != nb_configs) || (record_it != records.end() && (*record_it).second.key != (*it).key))
+            {
+                std::cout << shard_report_name << " comes from another config matrix, the shards are not merged" << std::endl;
+                return false;
+            }
+            records[(*it).config_id] = *it;
+            nb_configs = (*it).nb_configs;
+        }
+    }
+    if (!nb_read_shards || merged_report.header.empty())
+    {
+        std::cout << "No shard report of " << bench_file_name(in_bench_config.bench_type) << " to merge" << std::endl;
+        return false;
+    }
+    // The matrix line gives the number of configs even when no shard finished any
+    sscanf(merged_report.matrix.c_str() + std::min(merged_report.matrix.size(), BENCH_MATRIX_LINE.size()), "%u configs", &nb_configs);
+
+    std::deque<BenchResult> bench_results;
+    for (std::map<unsigned int, BenchRecord>::const_iterator it = records.begin(); it != records.end(); ++it)
+    {
+        merged_report.records.push_back((*it).second);
+        if ((*it).second.completed)
+        {
+            bench_results.push_back((*it).second.result);
+        }
+    }
+
+    const std::string merged_report_name = bench_file_name(in_bench_config.bench_type);
+    if (!write_bench_report(merged_report_name, merged_report))
+    {
+        return false;
+    }
+    std::ostringstream summary_stream;
+    print_bench_summary(summary_stream, in_bench_config.bench_type, bench_results);
+    summary_stream << BENCH_END_LINE << std::endl;
+    append_bench_report(merged_report_name, summary_stream.str());
+
+    std::cout << "| " << records.size() << " of " << nb_configs << " configs merged into " << merged_report_name << std::endl;
+    if (records.size() < nb_configs)
+    {
+        std::cout << "Warning : " << nb_configs - records.size() << " configs are missing, resume their shards before merging again" << std::endl;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+void set_camera(DisplayConfig& io_display_config, unsigned int in_frame_id)
+{
+    if (io_display_config.camera_mode == FIXED_STEP_CAMERA)
+    {
+        io_display_config.rotation_angle_x = default_rotation_angle_x;
+        io_display_config.rotation_angle_y = default_rotation_angle_y + CAMERA_STEP_ANGLE * in_frame_id;
+        io_display_config.move_forward = default_move_forward;
+    }
+    else if (io_display_config.camera_mode == ORBIT_PATH_CAMERA)
+    {
+        // One turn around the model, tilting up and down and zooming out then in
+        const double path_ratio = static_cast<double>(in_frame_id % CAMERA_PATH_NB_FRAMES) / CAMERA_PATH_NB_FRAMES;
+        io_display_config.rotation_angle_x = default_rotation_angle_x + 30.0 * sin(2.0 * M_PI * path_ratio);
+        io_display_config.rotation_angle_y = default_rotation_angle_y + 360.0 * path_ratio;
+        io_display_config.move_forward = default_move_forward - 0.5 * (1.0 - cos(2.0 * M_PI * path_ratio));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+const Geometry& model_geometry(const RenderingData& in_rendering_data)
+{
+    return in_rendering_data.p_shared_geometry ? *in_rendering_data.p_shared_geometry : in_rendering_data.geometry;
+}
+
+////////////////////////////////////////////////////////////////////////
+void init_rendering_data(RenderingData& out_rendering_data, const DisplayConfig& in_display_config)
+{
+    out_rendering_data.p_shared_geometry = NULL;
+    out_rendering_data.model_nb_triangles = 0;
+    out_rendering_data.model_in_memory = true;
+    out_rendering_data.streaming.nb_subdivisions = 0;
+    out_rendering_data.streaming.nb_chunk_rows = 0;
+    out_rendering_data.streaming.next_buffer = 0;
+    out_rendering_data.streaming.vertex_buffer_size = 0;
+    out_rendering_data.streaming.index_buffer_size = 0;
+    out_rendering_data.streaming.ring_size = 0;
+    clear_streaming_stats(out_rendering_data.streaming);
+    out_rendering_data.procedural.program_id = 0;
+    out_rendering_data.culling.program_id = 0;
+    out_rendering_data.culling.cluster_buffer_id = 0;
+    out_rendering_data.culling.command_buffer_id = 0;
+    out_rendering_data.culling.counter_buffer_id = 0;
+    out_rendering_data.culling.counter_copy_buffer_id = 0;
+    out_rendering_data.culling.nb_clusters = 0;
+    out_rendering_data.culling.buffers_size = 0;
+    out_rendering_data.culling.counter_fence = 0;
+    clear_culling_stats(out_rendering_data.culling);
+    out_rendering_data.scene_nb_draws = 0;
+    out_rendering_data.scene_nb_state_changes = 0;
+    out_rendering_data.rendering_width = in_display_config.windows_width;
+    out_rendering_data.rendering_height = in_display_config.windows_height;
+    out_rendering_data.framebuffer_id = 0;
+    out_rendering_data.color_renderbuffer_id = 0;
+    out_rendering_data.depth_renderbuffer_id = 0;
+    out_rendering_data.multisample.framebuffer_id = 0;
+    out_rendering_data.multisample.color_renderbuffer_id = 0;
+    out_rendering_data.multisample.depth_renderbuffer_id = 0;
+    out_rendering_data.multisample.nb_samples = 1;
+    out_rendering_data.multisample.first_pending_query = 0;
+    out_rendering_data.multisample.nb_pending_queries = 0;
+    out_rendering_data.multisample.frame_open = false;
+    out_rendering_data.texture_id = 0;
+    out_rendering_data.call_list_id = 0;
+    out_rendering_data.nb_call_lists = 0;
+    out_rendering_data.call_list_size = 0;
+    out_rendering_data.index_buffer_id  = 0;
+    out_rendering_data.vertex_buffer_id = 0;
+    out_rendering_data.index_buffer_size  = 0;
+    out_rendering_data.vertex_buffer_size = 0;
+    out_rendering_data.readback.width = 0;
+    out_rendering_data.readback.height = 0;
+    out_rendering_data.readback.frame_size = 0;
+    out_rendering_data.readback.frame_id = 0;
+    out_rendering_data.setup_times.generate_model = 0;
+    out_rendering_data.setup_times.texturing = 0;
+    out_rendering_data.setup_times.call_list = 0;
+    out_rendering_data.setup_times.vbo_packing = 0;
+    out_rendering_data.setup_times.vbo_upload = 0;
+    out_rendering_data.setup_times.shader_build = 0;
+    out_rendering_data.setup_times.first_frame = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+ScopedTrace::ScopedTrace(const char* in_name) : m_name(in_name), m_enabled(trace_data.enabled)
+{
+    if (m_enabled)
+    {
+        if (glPushDebugGroup)
+        {
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, m_name);
+        }
+        gettimeofday(&m_start, NULL);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+ScopedTrace::~ScopedTrace()
+{
+    if (m_enabled)
+    {
+        struct timeval end;
+        gettimeofday(&end, NULL);
+        add_trace_event(trace_data, m_name, elapsed_time_us(trace_data.start_time, m_start), elapsed_time_us(m_start, end), CPU_TRACK);
+        if (glPopDebugGroup)
+        {
+            glPopDebugGroup();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void start_trace(TraceData& io_trace_data)
+{
+    io_trace_data.events.clear();
+    io_trace_data.events.reserve(64 * 1024);
+    io_trace_data.nb_dropped_events = 0;
+
+    // Timestamp queries are only used when GPU and CPU times can be lined up
+    io_trace_data.first_pending_query = 0;
+    io_trace_data.nb_pending_queries = 0;
+    io_trace_data.gpu_frame_open = false;
+    if (glQueryCounter && glGetInteger64v && io_trace_data.query_ids.empty())
+    {
+        io_trace_data.query_ids.resize(2 * TRACE_QUERY_RING_SIZE);
+        glGenQueries(io_trace_data.query_ids.size(), &io_trace_data.query_ids[0]);
+    }
+    if (glGetInteger64v)
+    {
+        glGetInteger64v(GL_TIMESTAMP, &io_trace_data.gpu_start_time);
+    }
+
+    gettimeofday(&io_trace_data.start_time, NULL);
+    io_trace_data.enabled = true;
+}
+
+////////////////////////////////////////////////////////////////////////
+void stop_trace(TraceData& io_trace_data, const char* in_file_name)
+{
+    io_trace_data.enabled = false;
+
+    if (!io_trace_data.query_ids.empty())
+    {
+        glDeleteQueries(io_trace_data.query_ids.size(), &io_trace_data.query_ids[0]);
+        io_trace_data.query_ids.clear();
+    }
+
+    std::ofstream trace_stream(in_file_name);
+    write_trace(io_trace_data, trace_stream);
+    std::cout << std::endl << "| Trace written to " << in_file_name << " (" << io_trace_data.events.size() << " events";
+    if (io_trace_data.nb_dropped_events)
+    {
+        std::cout << ", " << io_trace_data.nb_dropped_events << " dropped";
+    }
+    std::cout << ")" << std::endl;
+
+    io_trace_data.events.clear();
+}
+
+////////////////////////////////////////////////////////////////////////
+void add_trace_event(TraceData& io_trace_data, const char* in_name, long in_begin, long in_duration, TraceTrack in_track)
+{
+    if (io_trace_data.events.size() >= TRACE_MAX_EVENTS)
+    {
+        ++io_trace_data.nb_dropped_events;
+        return;
+    }
+    TraceEvent event;
+    event.name = in_name;
+    event.begin = in_begin;
+    event.duration = in_duration;
+    event.track = in_track;
+    io_trace_data.events.push_back(event);
+}
+
+////////////////////////////////////////////////////////////////////////
+void begin_gpu_trace_frame(TraceData& io_trace_data)
+{
+    // No query this frame when every pair is still in flight, the trace must not stall the pipeline
+    if (!io_trace_data.enabled || io_trace_data.query_ids.empty() || io_trace_data.nb_pending_queries == TRACE_QUERY_RING_SIZE)
+    {
+        return;
+    }
+    const unsigned int slot = (io_trace_data.first_pending_query + io_trace_data.nb_pending_queries) % TRACE_QUERY_RING_SIZE;
+    glQueryCounter(io_trace_data.query_ids[2 * slot], GL_TIMESTAMP);
+    io_trace_data.gpu_frame_open = true;
+}
+
+////////////////////////////////////////////////////////////////////////
+void end_gpu_trace_frame(TraceData& io_trace_data)
+{
+    if (io_trace_data.gpu_frame_open)
+    {
+        const unsigned int slot = (io_trace_data.first_pending_query + io_trace_data.nb_pending_queries) % TRACE_QUERY_RING_SIZE;
+        glQueryCounter(io_trace_data.query_ids[2 * slot + 1], GL_TIMESTAMP);
+        ++io_trace_data.nb_pending_queries;
+        io_trace_data.gpu_frame_open = false;
+    }
+
+    // Collect the frames the GPU is done with
+    while (io_trace_data.nb_pending_queries)
+    {
+        const unsigned int slot = io_trace_data.first_pending_query;
+        GLint available = 0;
+        glGetQueryObjectiv(io_trace_data.query_ids[2 * slot + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            break;
+        }
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(io_trace_data.query_ids[2 * slot], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(io_trace_data.query_ids[2 * slot + 1], GL_QUERY_RESULT, &end);
+        add_trace_event(io_trace_data, "gpu frame", static_cast<long>((static_cast<GLint64>(begin) - io_trace_data.gpu_start_time) / 1000),
+                        static_cast<long>((end - begin) / 1000), GPU_TRACK);
+
+        io_trace_data.first_pending_query = (io_trace_data.first_pending_query + 1) % TRACE_QUERY_RING_SIZE;
+        --io_trace_data.nb_pending_queries;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void write_trace(const TraceData& in_trace_data, std::ostream& out_stream)
+{
+    // Chrome trace event format, complete events ("X") on one thread per track
+    out_stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" << std::endl;
+    out_stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << CPU_TRACK << ",\"args\":{\"name\":\"CPU\"}}," << std::endl;
+    out_stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_TRACK << ",\"args\":{\"name\":\"GPU\"}}";
+    for (std::vector<TraceEvent>::const_iterator it = in_trace_data.events.begin(); it != in_trace_data.events.end(); ++it)
+    {
+        out_stream << "," << std::endl << "{\"name\":\"" << (*it).name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (*it).track
+                   << ",\"ts\":" << (*it).begin << ",\"dur\":" << (*it).duration << "}";
+    }
+    out_stream << std::endl << "]}" << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////
+void init_sdl(const DisplayConfig& in_display_config)
+{
+    SDL_Init(SDL_INIT_VIDEO);
+
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_WM_SetCaption("GlBench", NULL);
+
+    SDL_SetVideoMode(in_display_config.windows_width, in_display_config.windows_height, 32, SDL_OPENGL | SDL_GL_DOUBLEBUFFER);
+}
+
+////////////////////////////////////////////////////////////////////////
+void init_gl_extensions()
+{
+    const unsigned char *exts = glGetString(GL_EXTENSIONS);
+    if (strstr(reinterpret_cast<const char*>(exts), "GL_ARB_vertex_buffer_object") == NULL)
+    {
+        std::cout << "Warning : VBO extension is not supported by our graphic card" << std::endl;
+    }
+    else
+    {
+        glGenBuffers    = reinterpret_cast<PFNGLGENBUFFERSPROC>   (SDL_GL_GetProcAddress("glGenBuffers"));
+        glBindBuffer    = reinterpret_cast<PFNGLBINDBUFFERPROC>   (SDL_GL_GetProcAddress("glBindBuffer"));
+        glBufferData    = reinterpret_cast<PFNGLBUFFERDATAPROC>   (SDL_GL_GetProcAddress("glBufferData"));
+        glBufferSubData = reinterpret_cast<PFNGLBUFFERSUBDATAPROC>(SDL_GL_GetProcAddress("glBufferSubData"));
+        glDeleteBuffers = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteBuffers"));
+        glMapBuffer     = reinterpret_cast<PFNGLMAPBUFFERPROC>    (SDL_GL_GetProcAddress("glMapBuffer"));
+        glUnmapBuffer   = reinterpret_cast<PFNGLUNMAPBUFFERPROC>  (SDL_GL_GetProcAddress("glUnmapBuffer"));
+    }
+
+    // Core names with ARB_framebuffer_object, same entry points with an EXT suffix otherwise
+    const char* framebuffer_suffix = NULL;
+    if (is_gl_extension_supported("GL_ARB_framebuffer_object"))
+    {
+        framebuffer_suffix = "";
+    }
+    else if (is_gl_extension_supported("GL_EXT_framebuffer_object"))
+    {
+        framebuffer_suffix = "EXT";
+    }
+    else
+    {
+        std::cout << "Warning : FBO extension is not supported, offscreen framebuffers are disabled" << std::endl;
+    }
+    if (framebuffer_suffix)
+    {
+        const std::string suffix(framebuffer_suffix);
+        glGenFramebuffers         = reinterpret_cast<PFNGLGENFRAMEBUFFERSPROC>        (SDL_GL_GetProcAddress(("glGenFramebuffers" + suffix).c_str()));
+        glBindFramebuffer         = reinterpret_cast<PFNGLBINDFRAMEBUFFERPROC>        (SDL_GL_GetProcAddress(("glBindFramebuffer" + suffix).c_str()));
+        glFramebufferRenderbuffer = reinterpret_cast<PFNGLFRAMEBUFFERRENDERBUFFERPROC>(SDL_GL_GetProcAddress(("glFramebufferRenderbuffer" + suffix).c_str()));
+        glCheckFramebufferStatus  = reinterpret_cast<PFNGLCHECKFRAMEBUFFERSTATUSPROC> (SDL_GL_GetProcAddress(("glCheckFramebufferStatus" + suffix).c_str()));
+        glDeleteFramebuffers      = reinterpret_cast<PFNGLDELETEFRAMEBUFFERSPROC>     (SDL_GL_GetProcAddress(("glDeleteFramebuffers" + suffix).c_str()));
+        glGenRenderbuffers        = reinterpret_cast<PFNGLGENRENDERBUFFERSPROC>       (SDL_GL_GetProcAddress(("glGenRenderbuffers" + suffix).c_str()));
+        glBindRenderbuffer        = reinterpret_cast<PFNGLBINDRENDERBUFFERPROC>       (SDL_GL_GetProcAddress(("glBindRenderbuffer" + suffix).c_str()));
+        glRenderbufferStorage     = reinterpret_cast<PFNGLRENDERBUFFERSTORAGEPROC>    (SDL_GL_GetProcAddress(("glRenderbufferStorage" + suffix).c_str()));
+        glDeleteRenderbuffers     = reinterpret_cast<PFNGLDELETERENDERBUFFERSPROC>    (SDL_GL_GetProcAddress(("glDeleteRenderbuffers" + suffix).c_str()));
+        // Core and ARB framebuffers, or the EXT multisample and blit extensions on top of EXT framebuffers
+        glRenderbufferStorageMultisample = reinterpret_cast<PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC>(SDL_GL_GetProcAddress(("glRenderbufferStorageMultisample" + suffix).c_str()));
+        glBlitFramebuffer                = reinterpret_cast<PFNGLBLITFRAMEBUFFERPROC>               (SDL_GL_GetProcAddress(("glBlitFramebuffer" + suffix).c_str()));
+        if (!glRenderbufferStorageMultisample || !glBlitFramebuffer)
+        {
+            std::cout << "Warning : Multisample framebuffer extension is not supported, offscreen framebuffers are single sampled" << std::endl;
+        }
+    }
+
+    if (!is_gl_extension_supported("GL_ARB_sync"))
+    {
+        std::cout << "Warning : Sync extension is not supported, PBO readback relies on buffer mapping to wait and streamed chunks orphan their buffers" << std::endl;
+    }
+    else
+    {
+        glFenceSync      = reinterpret_cast<PFNGLFENCESYNCPROC>     (SDL_GL_GetProcAddress("glFenceSync"));
+        glClientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(SDL_GL_GetProcAddress("glClientWaitSync"));
+        glDeleteSync     = reinterpret_cast<PFNGLDELETESYNCPROC>    (SDL_GL_GetProcAddress("glDeleteSync"));
+    }
+
+    // Timestamps and GL_TIMESTAMP queries for the GPU part of the trace, debug groups to line up external GL tracers
+    glGenQueries       = reinterpret_cast<PFNGLGENQUERIESPROC>      (SDL_GL_GetProcAddress("glGenQueries"));
+    glDeleteQueries    = reinterpret_cast<PFNGLDELETEQUERIESPROC>   (SDL_GL_GetProcAddress("glDeleteQueries"));
+    glGetQueryObjectiv = reinterpret_cast<PFNGLGETQUERYOBJECTIVPROC>(SDL_GL_GetProcAddress("glGetQueryObjectiv"));
+    if (!is_gl_extension_supported("GL_ARB_timer_query") || !glGenQueries)
+    {
+        std::cout << "Warning : Timer query extension is not supported, the trace has no GPU track" << std::endl;
+    }
+    else
+    {
+        glQueryCounter        = reinterpret_cast<PFNGLQUERYCOUNTERPROC>       (SDL_GL_GetProcAddress("glQueryCounter"));
+        glGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(SDL_GL_GetProcAddress("glGetQueryObjectui64v"));
+        glGetInteger64v       = reinterpret_cast<PFNGLGETINTEGER64VPROC>      (SDL_GL_GetProcAddress("glGetInteger64v"));
+    }
+    if (is_gl_extension_supported("GL_KHR_debug"))
+    {
+        glPushDebugGroup = reinterpret_cast<PFNGLPUSHDEBUGGROUPPROC>(SDL_GL_GetProcAddress("glPushDebugGroup"));
+        glPopDebugGroup  = reinterpret_cast<PFNGLPOPDEBUGGROUPPROC> (SDL_GL_GetProcAddress("glPopDebugGroup"));
+    }
+
+    // gl_VertexID needs GLSL 1.30
+    const char* glsl_version = reinterpret_cast<const char*>(glGetString(GL_SHADING_LANGUAGE_VERSION));
+    if (glsl_version == NULL || atof(glsl_version) < 1.3)
+    {
+        std::cout << "Warning : GLSL 1.30 is not supported, the procedural model is disabled" << std::endl;
+    }
+    else
+    {
+        glCreateShader       = reinterpret_cast<PFNGLCREATESHADERPROC>      (SDL_GL_GetProcAddress("glCreateShader"));
+        glShaderSource       = reinterpret_cast<PFNGLSHADERSOURCEPROC>      (SDL_GL_GetProcAddress("glShaderSource"));
+        glCompileShader      = reinterpret_cast<PFNGLCOMPILESHADERPROC>     (SDL_GL_GetProcAddress("glCompileShader"));
+        glGetShaderiv        = reinterpret_cast<PFNGLGETSHADERIVPROC>       (SDL_GL_GetProcAddress("glGetShaderiv"));
+        glGetShaderInfoLog   = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>  (SDL_GL_GetProcAddress("glGetShaderInfoLog"));
+        glDeleteShader       = reinterpret_cast<PFNGLDELETESHADERPROC>      (SDL_GL_GetProcAddress("glDeleteShader"));
+        glCreateProgram      = reinterpret_cast<PFNGLCREATEPROGRAMPROC>     (SDL_GL_GetProcAddress("glCreateProgram"));
+        glAttachShader       = reinterpret_cast<PFNGLATTACHSHADERPROC>      (SDL_GL_GetProcAddress("glAttachShader"));
+        glLinkProgram        = reinterpret_cast<PFNGLLINKPROGRAMPROC>       (SDL_GL_GetProcAddress("glLinkProgram"));
+        glGetProgramiv       = reinterpret_cast<PFNGLGETPROGRAMIVPROC>      (SDL_GL_GetProcAddress("glGetProgramiv"));
+        glGetProgramInfoLog  = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC> (SDL_GL_GetProcAddress("glGetProgramInfoLog"));
+        glDeleteProgram      = reinterpret_cast<PFNGLDELETEPROGRAMPROC>     (SDL_GL_GetProcAddress("glDeleteProgram"));
+        glUseProgram         = reinterpret_cast<PFNGLUSEPROGRAMPROC>        (SDL_GL_GetProcAddress("glUseProgram"));
+        glGetUniformLocation = reinterpret_cast<PFNGLGETUNIFORMLOCATIONPROC>(SDL_GL_GetProcAddress("glGetUniformLocation"));
+        glUniform1i          = reinterpret_cast<PFNGLUNIFORM1IPROC>         (SDL_GL_GetProcAddress("glUniform1i"));
+        glMultiDrawArrays    = reinterpret_cast<PFNGLMULTIDRAWARRAYSPROC>   (SDL_GL_GetProcAddress("glMultiDrawArrays"));
+    }
+
+    // Core in GL 4.3
+    if (!glCreateShader || !is_gl_extension_supported("GL_ARB_compute_shader") || !is_gl_extension_supported("GL_ARB_shader_storage_buffer_object")
+        || !is_gl_extension_supported("GL_ARB_multi_draw_indirect") || !is_gl_extension_supported("GL_ARB_copy_buffer") || !glFenceSync)
+    {
+        std::cout << "Warning : compute shaders or indirect draws are not supported, the GPU culling is disabled" << std::endl;
+    }
+    else
+    {
+        glDispatchCompute           = reinterpret_cast<PFNGLDISPATCHCOMPUTEPROC>          (SDL_GL_GetProcAddress("glDispatchCompute"));
+        glMemoryBarrier             = reinterpret_cast<PFNGLMEMORYBARRIERPROC>            (SDL_GL_GetProcAddress("glMemoryBarrier"));
+        glBindBufferBase            = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>           (SDL_GL_GetProcAddress("glBindBufferBase"));
+        glGetBufferSubData          = reinterpret_cast<PFNGLGETBUFFERSUBDATAPROC>         (SDL_GL_GetProcAddress("glGetBufferSubData"));
+        glCopyBufferSubData         = reinterpret_cast<PFNGLCOPYBUFFERSUBDATAPROC>        (SDL_GL_GetProcAddress("glCopyBufferSubData"));
+        glUniform3fv                = reinterpret_cast<PFNGLUNIFORM3FVPROC>               (SDL_GL_GetProcAddress("glUniform3fv"));
+        glUniform4fv                = reinterpret_cast<PFNGLUNIFORM4FVPROC>               (SDL_GL_GetProcAddress("glUniform4fv"));
+        glMultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(SDL_GL_GetProcAddress("glMultiDrawElementsIndirect"));
+    }
+
+    if (!is_gl_extension_supported("GL_ARB_pixel_buffer_object"))
+    {
+        std::cout << "Warning : PBO extension is not supported by our graphic card" << std::endl;
+    }
+    if (!is_gl_extension_supported("GL_EXT_texture_compression_s3tc"))
+    {
+        std::cout << "Warning : S3TC extension is not supported, compressed textures use the driver's generic format" << std::endl;
+    }
+    if (!is_gl_extension_supported("GL_ARB_texture_float"))
+    {
+        std::cout << "Warning : Float texture extension is not supported, float textures fall back to RGBA8" << std::endl;
+    }
+    if (!is_gl_extension_supported("GL_EXT_texture_filter_anisotropic"))
+    {
+        std::cout << "Warning : Anisotropic filtering extension is not supported, anisotropic filter falls back to trilinear" << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void set_swap_interval(SwapControl in_swap_control)
+{
+    if (in_swap_control == DRIVER_SWAP_INTERVAL)
+    {
+        return;
+    }
+
+    int swap_interval = (in_swap_control == NO_VSYNC) ? 0 : ((in_swap_control == VSYNC) ? 1 : -1);
+
+    Display* p_display = glXGetCurrentDisplay();
+    const char* glx_extensions = p_display ? glXQueryExtensionsString(p_display, DefaultScreen(p_display)) : NULL;
+    if (glx_extensions == NULL)
+    {
+        std::cout << "Warning : no GLX display, the swap interval is not changed" << std::endl;
+        return;
+    }
+
+    // Negative interval : vsync only if the frame is on time, tear otherwise
+    if (swap_interval < 0 && strstr(glx_extensions, "GLX_EXT_swap_control_tear") == NULL)
+    {
+        std::cout << "Warning : adaptive vsync is not supported, swap interval is 1" << std::endl;
+        swap_interval = 1;
+    }
+
+    if (strstr(glx_extensions, "GLX_EXT_swap_control"))
+    {
+        PFNGLXSWAPINTERVALEXTPROC p_swap_interval = reinterpret_cast<PFNGLXSWAPINTERVALEXTPROC>(SDL_GL_GetProcAddress("glXSwapIntervalEXT"));
+        p_swap_interval(p_display, glXGetCurrentDrawable(), swap_interval);
+    }
+    else if (strstr(glx_extensions, "GLX_MESA_swap_control") && swap_interval >= 0)
+    {
+        PFNGLXSWAPINTERVALMESAPROC p_swap_interval = reinterpret_cast<PFNGLXSWAPINTERVALMESAPROC>(SDL_GL_GetProcAddress("glXSwapIntervalMESA"));
+        p_swap_interval(static_cast<unsigned int>(swap_interval));
+    }
+    else if (strstr(glx_extensions, "GLX_SGI_swap_control") && swap_interval > 0)   // SGI can not disable vsync
+    {
+        PFNGLXSWAPINTERVALSGIPROC p_swap_interval = reinterpret_cast<PFNGLXSWAPINTERVALSGIPROC>(SDL_GL_GetProcAddress("glXSwapIntervalSGI"));
+        p_swap_interval(swap_interval);
+    }
+    else
+    {
+        std::cout << "Warning : swap interval " << swap_interval << " is not supported by the GLX driver" << std::endl;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+bool is_gl_extension_supported(const char* in_extension_name)
+{
+    const unsigned char *exts = glGetString(GL_EXTENSIONS);
+    return exts != NULL && strstr(reinterpret_cast<const char*>(exts), in_extension_name) != NULL;
+}
+
+////////////////////////////////////////////////////////////////////////
+void init_gl(RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config)
+{
+    ScopedTrace trace("init_gl");
+    GL_COUNTERS_BEGIN_SETUP();
+
+    // Scene objects share a smaller mesh, generated again when a bench config changes its size or where it is built
+    if (io_rendering_data.model_nb_triangles != nb_mesh_triangles(in_rendering_config)
+        ||
+        io_rendering_data.model_in_memory != model_kept_in_memory(in_rendering_config))
+    {
+        generate_model(in_rendering_config, io_rendering_data);
+    }
+
+    // Render target first, it gives the viewport size
+    process_framebuffer(io_rendering_data, in_display_config, in_rendering_config);
+
+    glViewport(0 , 0, static_cast<GLsizei>(io_rendering_data.rendering_width), static_cast<GLsizei>(io_rendering_data.rendering_height));
+
+    set_gl_state(in_rendering_config);
+
+    process_texturing(io_rendering_data, in_rendering_config);
+    process_call_list(io_rendering_data, in_rendering_config);
+    process_vbo(io_rendering_data, in_rendering_config);
+    process_streaming(io_rendering_data, in_rendering_config);
+    process_procedural(io_rendering_data, in_rendering_config);
+    process_culling(io_rendering_data, in_rendering_config);
+    process_readback(io_rendering_data, in_rendering_config);
+    process_scene(io_rendering_data, in_rendering_config);
+}
+
+////////////////////////////////////////////////////////////////////////
+void set_gl_state(const RenderingConfig& in_rendering_config)
+{
+    if (in_rendering_config.rendering_options.test(WIREFRAME))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    }
+    else
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
+
+    glEnable(GL_DEPTH_TEST);                // Enable Z-buffer for visibility
+    // Mesh overdraw passes must not be rejected by the depth test of the previous pass
+    glDepthFunc((in_rendering_config.nb_overdraw_passes > 1 && !in_rendering_config.rendering_options.test(FULL_SCREEN_OVERDRAW)) ? GL_LEQUAL : GL_LESS);
+    set_lights(in_rendering_config);
+
+    glEnable(GL_COLOR_MATERIAL);
+
+    // Back face painting
+    if (in_rendering_config.rendering_options.test(BACK_FACE_PAINTING))
+    {
+        glDisable(GL_CULL_FACE);
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE);
+    }
+    else
+    {
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+        glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_FALSE);
+    }
+    if (glCreateShader)     // vertex shaders pick the back color themselves
+    {
+        if (in_rendering_config.rendering_options.test(BACK_FACE_PAINTING))
+            glEnable(GL_VERTEX_PROGRAM_TWO_SIDE);
+        else
+            glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+    }
+
+    // Texturing
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+    {
+        glEnable(GL_TEXTURE_2D);
+    }
+    else
+    {
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    // Smooth shading
+    glShadeModel(in_rendering_config.rendering_options.test(SMOOTH_SHADING) ? GL_SMOOTH : GL_FLAT);
+
+    // Scene objects are scaled down, keep their normals unit length
+    if (in_rendering_config.nb_scene_objects > 1)
+    {
+        glEnable(GL_RESCALE_NORMAL);
+    }
+    else
+    {
+        glDisable(GL_RESCALE_NORMAL);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void set_lights(const RenderingConfig& in_rendering_config)
+{
+    if (in_rendering_config.nb_lights)
+    {
+        glEnable(GL_LIGHTING);
+    }
+    else
+    {
+        glDisable(GL_LIGHTING);
+    }
+    glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, in_rendering_config.rendering_options.test(LOCAL_VIEWER) ? GL_TRUE : GL_FALSE);
+
+    // The lights share the intensity of the single light, the model keeps its brightness
+    const GLfloat intensity = 1.0f / std::max(1U, in_rendering_config.nb_lights);
+    const GLfloat light_color[] = {intensity, intensity, intensity, 1.0f};
+    const bool positional = (in_rendering_config.light_type != DIRECTIONAL_LIGHT);
+    const bool spot = (in_rendering_config.light_type == SPOT_LIGHT);
+    for (unsigned int i = 0; i < MAX_LIGHTS; ++i)
+    {
+        const GLenum light = GL_LIGHT0 + i;
+        if (i >= in_rendering_config.nb_lights)
+        {
+            glDisable(light);
+            continue;
+        }
+        glEnable(light);
+        glLightfv(light, GL_DIFFUSE, light_color);
+        glLightfv(light, GL_SPECULAR, light_color);
+        glLightf(light, GL_LINEAR_ATTENUATION, positional ? LIGHT_LINEAR_ATTENUATION : 0.0f);
+        glLightf(light, GL_SPOT_CUTOFF, spot ? SPOT_LIGHT_CUTOFF : 180.0f);
+        glLightf(light, GL_SPOT_EXPONENT, spot ? SPOT_LIGHT_EXPONENT : 0.0f);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void position_lights(const RenderingConfig& in_rendering_config)
+{
+    // Positions and spot directions are transformed by the current modelview matrix
+    const GLfloat w = (in_rendering_config.light_type == DIRECTIONAL_LIGHT) ? 0.0f : 1.0f;
+    for (unsigned int i = 0; i < in_rendering_config.nb_lights; ++i)
+    {
+        const double angle = 2.0 * M_PI * i / MAX_LIGHTS;
+        const GLfloat light_position[] = {static_cast<GLfloat>(2.0 * sin(angle)), static_cast<GLfloat>(2.0 * cos(angle)), 1.0f, w};
+        glLightfv(GL_LIGHT0 + i, GL_POSITION, light_position);
+        if (in_rendering_config.light_type == SPOT_LIGHT)
+        {
+            const GLfloat spot_direction[] = {-light_position[0], -light_position[1], -light_position[2]};
+            glLightfv(GL_LIGHT0 + i, GL_SPOT_DIRECTION, spot_direction);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+EventType event_sdl(DisplayConfig& io_display_config, RenderingConfig& io_rendering_config, BenchConfig& io_bench_config)
+{
+    static int mouse_current_position_x = -1;
+    static int mouse_current_position_y = -1;
+    static bool mouse_left_button_down = false;
+
+    EventType event_type = NO_EVENT;
+
+    SDL_PumpEvents();                       // load all the events
+
+    SDL_Event event;
+
+    while (event_type != QUIT_REQUESTED
+           &&
+           SDL_PollEvent(&event))           // poll event by event
+    {
+        switch (event.type)
+        {
+            ///////////////////////////////////
+            case SDL_KEYDOWN:
+                switch (event.key.keysym.sym)
+                {
+                    case SDLK_q:
+                    case SDLK_ESCAPE:
+                        event_type = QUIT_REQUESTED;
+                        break;
+
+                    case SDLK_EQUALS:
+                    case SDLK_PLUS:
+                    case SDLK_KP_PLUS:
+                        io_rendering_config.nb_triangles *= 2;
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+
+                    case SDLK_MINUS:
+                    case SDLK_KP_MINUS:
+                        if (io_rendering_config.nb_triangles > 2500)
+                        {
+                            io_rendering_config.nb_triangles /= 2;
+                        }
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_w:
+                        io_rendering_config.rendering_options.flip(WIREFRAME);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_m:
+                        io_rendering_config.rendering_options.flip(SMOOTH_SHADING);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_c:
+                        io_rendering_config.rendering_options.flip(COLOR);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_t:
+                        io_rendering_config.rendering_options.flip(TEXTURE);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_p:
+                        io_rendering_config.rendering_options.flip(BACK_FACE_PAINTING);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_s:
+                        io_rendering_config.rendering_options.flip(TRIANGLE_STRIP);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_z:
+                    {
+                        unsigned int texture_size_id = 0;
+                        while (texture_size_id < NB_TEXTURE_SIZES && TEXTURE_SIZES[texture_size_id] != io_rendering_config.texture_size)
+                        {
+                            ++texture_size_id;
+                        }
+                        io_rendering_config.texture_size = TEXTURE_SIZES[(texture_size_id + 1) % NB_TEXTURE_SIZES];
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    }
+                    case SDLK_x:
+                        io_rendering_config.texture_format = static_cast<TextureFormat>((io_rendering_config.texture_format + 1) % NB_TEXTURE_FORMAT);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_f:
+                        io_rendering_config.texture_filter = static_cast<TextureFilter>((io_rendering_config.texture_filter + 1) % NB_TEXTURE_FILTER);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_r:
+                        io_rendering_config.readback_mode = static_cast<ReadbackMode>((io_rendering_config.readback_mode + 1) % NB_READBACK_MODE);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_e:
+                        io_rendering_config.readback_format = static_cast<ReadbackFormat>((io_rendering_config.readback_format + 1) % NB_READBACK_FORMAT);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_g:
+                        io_rendering_config.rendering_options.flip(CAPTURE);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_n:
+                    {
+                        unsigned int framebuffer_size_id = 0;
+                        while (framebuffer_size_id < NB_FRAMEBUFFER_SIZES && FRAMEBUFFER_SIZES[framebuffer_size_id][0] != io_rendering_config.framebuffer_width)
+                        {
+                            ++framebuffer_size_id;
+                        }
+                        framebuffer_size_id = (framebuffer_size_id + 1) % NB_FRAMEBUFFER_SIZES;
+                        io_rendering_config.framebuffer_width  = FRAMEBUFFER_SIZES[framebuffer_size_id][0];
+                        io_rendering_config.framebuffer_height = FRAMEBUFFER_SIZES[framebuffer_size_id][1];
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    }
+                    case SDLK_o:
+                    {
+                        unsigned int overdraw_passes_id = 0;
+                        while (overdraw_passes_id < NB_OVERDRAW_PASSES && OVERDRAW_PASSES[overdraw_passes_id] != io_rendering_config.nb_overdraw_passes)
+                        {
+                            ++overdraw_passes_id;
+                        }
+                        io_rendering_config.nb_overdraw_passes = OVERDRAW_PASSES[(overdraw_passes_id + 1) % NB_OVERDRAW_PASSES];
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    }
+                    case SDLK_l:
+                        io_rendering_config.rendering_options.flip(FULL_SCREEN_OVERDRAW);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_d:
+                    {
+                        unsigned int scene_objects_id = 0;
+                        while (scene_objects_id < NB_SCENE_OBJECTS && SCENE_OBJECTS[scene_objects_id] != io_rendering_config.nb_scene_objects)
+                        {
+                            ++scene_objects_id;
+                        }
+                        io_rendering_config.nb_scene_objects = SCENE_OBJECTS[(scene_objects_id + 1) % NB_SCENE_OBJECTS];
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    }
+                    case SDLK_u:
+                        io_rendering_config.rendering_options.flip(SORTED_SCENE);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_h:
+                        io_rendering_config.call_list_build = static_cast<CallListBuild>((io_rendering_config.call_list_build + 1) % NB_CALL_LIST_BUILD);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_k:
+                        io_rendering_config.rendering_options.flip(CHUNKED_UPLOAD);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_a:
+                        io_bench_config.bench_type = static_cast<BenchType>((io_bench_config.bench_type + 1) % NB_BENCH_TYPE);
+                        event_type = BENCH_CONFIG_CHANGED;
+                        break;
+                    case SDLK_F1:
+                    case SDLK_F2:
+                    case SDLK_F3:
+                    case SDLK_F4:
+                    case SDLK_F5:
+                    case SDLK_F6:
+                    case SDLK_F7:
+                        io_rendering_config.rendering_method = static_cast<RenderingMethod>(event.key.keysym.sym - SDLK_F1 + 1);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_F8:
+                    {
+                        unsigned int samples_id = 0;
+                        while (samples_id < NB_MSAA_SAMPLES && MSAA_SAMPLES[samples_id] != io_rendering_config.nb_samples)
+                        {
+                            ++samples_id;
+                        }
+                        io_rendering_config.nb_samples = MSAA_SAMPLES[(samples_id + 1) % NB_MSAA_SAMPLES];
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    }
+                    case SDLK_F9:
+                        io_rendering_config.depth_format = static_cast<DepthFormat>((io_rendering_config.depth_format + 1) % NB_DEPTH_FORMAT);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_F10:
+                        io_rendering_config.nb_lights = (io_rendering_config.nb_lights + 1) % (MAX_LIGHTS + 1);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_F11:
+                        io_rendering_config.light_type = static_cast<LightType>((io_rendering_config.light_type + 1) % NB_LIGHT_TYPE);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_F12:
+                        io_rendering_config.rendering_options.flip(LOCAL_VIEWER);
+                        event_type = RENDERING_CONFIG_CHANGED;
+                        break;
+                    case SDLK_SPACE:
+                        io_display_config.rotation = !io_display_config.rotation;
+                        break;
+                    case SDLK_v:
+                        // The driver default can not be restored once changed
+                        io_display_config.swap_control = static_cast<SwapControl>((io_display_config.swap_control + 1) % NB_SWAP_CONTROL);
+                        if (io_display_config.swap_control == DRIVER_SWAP_INTERVAL)
+                        {
+                            io_display_config.swap_control = NO_VSYNC;
+                        }
+                        event_type = DISPLAY_CONFIG_CHANGED;
+                        break;
+                    case SDLK_y:
+                        io_display_config.latency_measure = !io_display_config.latency_measure;
+                        event_type = DISPLAY_CONFIG_CHANGED;
+                        break;
+                    case SDLK_i:
+                        io_display_config.camera_mode = static_cast<CameraMode>((io_display_config.camera_mode + 1) % NB_CAMERA_MODE);
+                        event_type = DISPLAY_CONFIG_CHANGED;
+                        break;
+                    case SDLK_j:
+                        io_display_config.trace = !io_display_config.trace;
+                        event_type = DISPLAY_CONFIG_CHANGED;
+                        break;
+                    case SDLK_b:
+                        event_type = BENCH_REQUESTED;
+
+                    default:
+                        break;
+                }
+                break;
+
+            ///////////////////////////////////
+            case SDL_MOUSEBUTTONDOWN:
+                if (event.button.button == SDL_BUTTON_LEFT)
+                {
+                    mouse_left_button_down = true;
+                    mouse_current_position_x = -1;
+                    mouse_current_position_y = -1;
+                }
+                else if (event.button.button == SDL_BUTTON_WHEELDOWN)
+                {
+                    io_display_config.move_forward -= 0.1;
+                }
+                else if (event.button.button == SDL_BUTTON_WHEELUP)
+                {
+                    io_display_config.move_forward += 0.1;
+                }
+                break;
+
+            ///////////////////////////////////
+            case SDL_MOUSEBUTTONUP:
+                if (event.button.button == SDL_BUTTON_LEFT)
+                {
+                    mouse_left_button_down = false;
+                }
+                break;
+
+            ///////////////////////////////////
+            case SDL_MOUSEMOTION:
+                if (mouse_left_button_down)
+                {
+                    if (mouse_current_position_x == -1 || mouse_current_position_y == -1)
+                    {
+                        mouse_current_position_x = event.button.x;
+                        mouse_current_position_y = event.button.y;
+                    }
+                    else
+                    {
+                        io_display_config.rotation_angle_x += event.button.y - mouse_current_position_y;
+                        io_display_config.rotation_angle_y += event.button.x - mouse_current_position_x;
+                        mouse_current_position_x = event.button.x;
+                        mouse_current_position_y = event.button.y;
+                    }
+                }
+                break;
+
+            ///////////////////////////////////
+            case SDL_QUIT:                  // Quit resquested : "close button" of the window
+                event_type = QUIT_REQUESTED;
+                break;
+
+            ///////////////////////////////////
+            default:
+                break;
+        }
+    }
+
+    return event_type;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+double frame_nb_pixels(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    return static_cast<double>(in_rendering_data.rendering_width) * in_rendering_data.rendering_height * in_rendering_config.nb_overdraw_passes;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_setup_times(std::ostream& out_stream, const SetupTimes& in_setup_times)
+{
+    const long time_to_first_frame = in_setup_times.generate_model + in_setup_times.texturing + in_setup_times.call_list
+                                   + in_setup_times.vbo_packing + in_setup_times.vbo_upload + in_setup_times.shader_build
+                                   + in_setup_times.first_frame;
+
+    out_stream << "| setup : model ";
+    print_fixed(out_stream, in_setup_times.generate_model / 1000.0, 1);
+    out_stream << " ms, texture ";
+    print_fixed(out_stream, in_setup_times.texturing / 1000.0, 1);
+    out_stream << " ms, call list ";
+    print_fixed(out_stream, in_setup_times.call_list / 1000.0, 1);
+    out_stream << " ms, VBO packing ";
+    print_fixed(out_stream, in_setup_times.vbo_packing / 1000.0, 1);
+    out_stream << " ms, VBO upload ";
+    print_fixed(out_stream, in_setup_times.vbo_upload / 1000.0, 1);
+    out_stream << " ms, shader ";
+    print_fixed(out_stream, in_setup_times.shader_build / 1000.0, 1);
+    out_stream << " ms, first frame ";
+    print_fixed(out_stream, in_setup_times.first_frame / 1000.0, 1);
+    out_stream << " ms, time to first frame ";
+    print_fixed(out_stream, time_to_first_frame / 1000.0, 1);
+    out_stream << " ms      " << std::flush;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_memory_usage(std::ostream& out_stream, const RenderingData& in_rendering_data)
+{
+    size_t rss = 0;
+    size_t peak_rss = 0;
+    read_process_memory(rss, peak_rss);
+
+    const double mega_byte = 1024.0 * 1024.0;
+    out_stream << "| memory : geometry ";
+    print_fixed(out_stream, geometry_size(model_geometry(in_rendering_data)) / mega_byte, 1);
+    out_stream << " MB, GPU buffers ";
+    print_fixed(out_stream, (in_rendering_data.vertex_buffer_size + in_rendering_data.index_buffer_size + in_rendering_data.streaming.ring_size
+                              + in_rendering_data.culling.buffers_size) / mega_byte, 1);
+    out_stream << " MB, call lists ";
+    print_fixed(out_stream, in_rendering_data.call_list_size / mega_byte, 1);
+    out_stream << " MB, RSS ";
+    print_fixed(out_stream, rss / mega_byte, 1);
+    out_stream << " MB, peak RSS ";
+    print_fixed(out_stream, peak_rss / mega_byte, 1);
+    out_stream << " MB      " << std::flush;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_scene_stats(std::ostream& out_stream, const RenderingData& in_rendering_data, const std::deque<long>& in_rendering_times)
+{
+    if (in_rendering_data.scene_objects.empty())
+    {
+        return;
+    }
+    const double mean_rendering_time = mean_time(in_rendering_times);   // us
+
+    out_stream << "| scene : " << in_rendering_data.scene_objects.size() << " objects, " << in_rendering_data.scene_nb_draws << " draws and "
+               << in_rendering_data.scene_nb_state_changes << " state changes per frame";
+    if (mean_rendering_time > 0.0)
+    {
+        out_stream << " (";
+        print_fixed(out_stream, in_rendering_data.scene_nb_draws * 1000.0 / mean_rendering_time, 1);
+        out_stream << " kdraws/s)";
+    }
+    out_stream << "      " << std::flush;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_fill_rate_summary(std::ostream& out_stream, const std::deque<BenchResult>& in_bench_results)
+{
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Fill rate summary : frame time = vertex cost + pixel cost" << std::endl;
+
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        // Least squares fit of the frame time against the number of pixels, over every size of this method
+        double sum_pixels = 0.0, sum_times = 0.0, sum_pixels_times = 0.0, sum_pixels_pixels = 0.0;
+        unsigned int nb_results = 0;
+        for (std::deque<BenchResult>::const_iterator it = in_bench_results.begin(); it != in_bench_results.end(); ++it)
+        {
+            if ((*it).rendering_config.rendering_method == rendering_method)
+            {
+                const double nb_pixels = static_cast<double>((*it).rendering_width) * (*it).rendering_height * (*it).rendering_config.nb_overdraw_passes;
+                sum_pixels += nb_pixels;
+                sum_times += (*it).mean_rendering_time;
+                sum_pixels_times += nb_pixels * (*it).mean_rendering_time;
+                sum_pixels_pixels += nb_pixels * nb_pixels;
+                ++nb_results;
+            }
+        }
+
+        const double denominator = nb_results * sum_pixels_pixels - sum_pixels * sum_pixels;
+        if (nb_results < 2 || denominator <= 0.0)
+        {
+            continue;
+        }
+        double pixel_cost = (nb_results * sum_pixels_times - sum_pixels * sum_times) / denominator;  // us per pixel
+        if (pixel_cost < 0.0)
+        {
+            pixel_cost = 0.0;
+        }
+        double vertex_cost = (sum_times - pixel_cost * sum_pixels) / nb_results;                     // us per frame
+        if (vertex_cost < 0.0)
+        {
+            vertex_cost = 0.0;
+        }
+
+        RenderingConfig rendering_config;
+        rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+        print_config_method(rendering_config, out_stream);
+        out_stream << "   vertex cost ";
+        print_fixed(out_stream, vertex_cost / 1000.0, 2);
+        out_stream << " ms, pixel cost ";
+        print_fixed(out_stream, pixel_cost * 1000.0, 2);   // us per pixel == s per Mpixel
+        out_stream << " ms per Mpixel" << std::endl;
+
+        for (std::deque<BenchResult>::const_iterator it = in_bench_results.begin(); it != in_bench_results.end(); ++it)
+        {
+            if ((*it).rendering_config.rendering_method == rendering_method)
+            {
+                const double nb_pixels = static_cast<double>((*it).rendering_width) * (*it).rendering_height * (*it).rendering_config.nb_overdraw_passes;
+                const double frame_time = vertex_cost + pixel_cost * nb_pixels;
+                const double pixel_ratio = (frame_time > 0.0) ? pixel_cost * nb_pixels / frame_time : 0.0;
+                out_stream << "   " << (*it).rendering_width << "x" << (*it).rendering_height << " : "
+                           << static_cast<unsigned int>(100.0 * pixel_ratio + 0.5) << "% pixel cost, "
+                           << ((pixel_ratio > 0.5) ? "fill-bound" : "vertex-bound") << std::endl;
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_lighting_summary(std::ostream& out_stream, const std::deque<BenchResult>& in_bench_results)
+{
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Lighting summary : Mtri/s for each number of lights, time per light and per Mtri" << std::endl;
+
+    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    {
+        bool method_printed = false;
+        for (std::deque<BenchResult>::const_iterator it = in_bench_results.begin(); it != in_bench_results.end(); ++it)
+        {
+            if ((*it).rendering_config.rendering_method == rendering_method && (*it).rendering_config.nb_lights == 0 && (*it).mean_rendering_time > 0.0)
+            {
+                print_config_method((*it).rendering_config, out_stream);
+                out_stream << "   Unlit : ";
+                print_fixed(out_stream, frame_nb_triangles((*it).rendering_config) / (*it).mean_rendering_time, 1);
+                out_stream << " Mtri/s" << std::endl;
+                method_printed = true;
+            }
+        }
+
+        for (unsigned int light_type = DIRECTIONAL_LIGHT; light_type < NB_LIGHT_TYPE; ++light_type)
+        {
+            for (unsigned int local_viewer = 0; local_viewer < 2; ++local_viewer)
+            {
+                // Least squares fit of the time per triangle against the number of lights
+                double sum_lights = 0.0, sum_times = 0.0, sum_lights_times = 0.0, sum_lights_lights = 0.0;
+                unsigned int nb_results = 0;
+                std::ostringstream rates_stream;
+                for (std::deque<BenchResult>::const_iterator it = in_bench_results.begin(); it != in_bench_results.end(); ++it)
+                {
+                    const RenderingConfig& rendering_config = (*it).rendering_config;
+                    if (rendering_config.rendering_method == rendering_method && rendering_config.nb_lights && rendering_config.light_type == light_type
+                        && rendering_config.rendering_options.test(LOCAL_VIEWER) == (local_viewer != 0) && (*it).mean_rendering_time > 0.0)
+                    {
+                        const double time_per_mtri = (*it).mean_rendering_time / frame_nb_triangles(rendering_config) * 1000.0;   // ms per Mtri
+                        sum_lights += rendering_config.nb_lights;
+                        sum_times += time_per_mtri;
+                        sum_lights_times += rendering_config.nb_lights * time_per_mtri;
+                        sum_lights_lights += static_cast<double>(rendering_config.nb_lights) * rendering_config.nb_lights;
+                        ++nb_results;
+
+                        rates_stream << (nb_results > 1 ? ", " : "") << rendering_config.nb_lights << " : ";
+                        print_fixed(rates_stream, 1.0 / time_per_mtri * 1000.0, 1);
+                    }
+                }
+                if (!nb_results)
+                {
+                    continue;
+                }
+                if (!method_printed)
+                {
+                    RenderingConfig rendering_config;
+                    rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+                    print_config_method(rendering_config, out_stream);
+                    method_printed = true;
+                }
+
+                out_stream << "   " << light_type_name(static_cast<LightType>(light_type)) << (local_viewer ? ", local viewer" : ", infinite viewer")
+                           << " : " << rates_stream.str() << " Mtri/s";
+                const double denominator = nb_results * sum_lights_lights - sum_lights * sum_lights;
+                if (nb_results >= 2 && denominator > 0.0)
+                {
+                    out_stream << ", ";
+                    print_fixed(out_stream, (nb_results * sum_lights_times - sum_lights * sum_times) / denominator, 2);
+                    out_stream << " ms per light per Mtri";
+                }
+                out_stream << std::endl;
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_readback_time(std::ostream& out_stream, const ReadbackData& in_readback_data, const RenderingConfig& in_rendering_config)
+{
+    if (in_rendering_config.readback_mode == NO_READBACK || in_readback_data.readback_times.empty())
+    {
+        return;
+    }
+
+    double mean_readback_time = 0.0;
+    for (std::deque<long>::const_iterator it = in_readback_data.readback_times.begin(); it != in_readback_data.readback_times.end(); ++it)
+    {
+        mean_readback_time += static_cast<double>(*it);
+    }
+    mean_readback_time = mean_readback_time / static_cast<double>(in_readback_data.readback_times.size());
+
+    // A frame read in the pixel buffer ring is consumed when the ring comes back to it
+    const unsigned int latency = (in_rendering_config.readback_mode == PBO_READBACK) ? in_readback_data.pixel_buffer_ids.size() - 1 : 0;
+
+    out_stream << "| readback in " << static_cast<unsigned int>(mean_readback_time + 0.5) << " us";
+    if (mean_readback_time > 0.0)
+    {
+        out_stream << " (" << static_cast<unsigned int>(static_cast<double>(in_readback_data.frame_size) / mean_readback_time + 0.5) << " MB/s)";
+    }
+    out_stream << ", +" << latency << " frame(s) latency      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_scene(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    io_rendering_data.scene_objects.clear();
+    io_rendering_data.scene_nb_draws = 0;
+    io_rendering_data.scene_nb_state_changes = 0;
+
+    if (in_rendering_config.nb_scene_objects <= 1)
+    {
+        return;
+    }
+
+    // Objects on a grid facing the camera, with a random state from a fixed seed so that runs compare
+    const unsigned int grid_size = static_cast<unsigned int>(ceil(sqrt(static_cast<double>(in_rendering_config.nb_scene_objects))));
+    const double cell_size = 2.0 / grid_size;
+    unsigned int seed = SCENE_SEED;
+    for (unsigned int i = 0; i < in_rendering_config.nb_scene_objects; ++i)
+    {
+        SceneObject object;
+        object.position = Vector3d(-1.0 + cell_size * (i % grid_size + 0.5), -1.0 + cell_size * (i / grid_size + 0.5), 0.0);
+        object.scale = 0.4 * cell_size;
+
+        seed = seed * 1103515245 + 12345;
+        object.texture = in_rendering_config.rendering_options.test(TEXTURE) && ((seed >> 16) & 1);
+        object.culling = (seed >> 17) & 1;
+        object.material_id = (seed >> 18) % SCENE_NB_MATERIALS;
+
+        io_rendering_data.scene_objects.push_back(object);
+    }
+
+    if (in_rendering_config.rendering_options.test(SORTED_SCENE))
+    {
+        std::sort(io_rendering_data.scene_objects.begin(), io_rendering_data.scene_objects.end(), scene_object_less);
+    }
+
+    // Same submission as draw_scene, counted once
+    const SceneObject* p_previous_object = NULL;
+    for (std::vector<SceneObject>::const_iterator it = io_rendering_data.scene_objects.begin(); it != io_rendering_data.scene_objects.end(); ++it)
+    {
+        const unsigned int state_changes = scene_state_changes(in_rendering_config.rendering_options.test(SORTED_SCENE) ? p_previous_object : NULL, *it);
+        io_rendering_data.scene_nb_state_changes += ((state_changes & SCENE_TEXTURE_CHANGE) ? 1 : 0)
+                                                  + ((state_changes & SCENE_CULLING_CHANGE) ? 1 : 0)
+                                                  + ((state_changes & SCENE_MATERIAL_CHANGE) ? 1 : 0);
+        p_previous_object = &(*it);
+    }
+    io_rendering_data.scene_nb_draws = in_rendering_config.nb_scene_objects * draw_model_nb_draws(io_rendering_data, in_rendering_config);
+}
+
+////////////////////////////////////////////////////////////////////////
+bool scene_object_less(const SceneObject& in_object1, const SceneObject& in_object2)
+{
+    // Most expensive state first
+    if (in_object1.texture != in_object2.texture)
+        return in_object1.texture < in_object2.texture;
+    if (in_object1.culling != in_object2.culling)
+        return in_object1.culling < in_object2.culling;
+    return in_object1.material_id < in_object2.material_id;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int scene_state_changes(const SceneObject* in_p_previous_object, const SceneObject& in_object)
+{
+    // Without a previous object every state is set again, as a naive submission does
+    if (in_p_previous_object == NULL)
+    {
+        return SCENE_TEXTURE_CHANGE | SCENE_CULLING_CHANGE | SCENE_MATERIAL_CHANGE;
+    }
+    unsigned int state_changes = 0;
+    if (in_p_previous_object->texture != in_object.texture)
+        state_changes |= SCENE_TEXTURE_CHANGE;
+    if (in_p_previous_object->culling != in_object.culling)
+        state_changes |= SCENE_CULLING_CHANGE;
+    if (in_p_previous_object->material_id != in_object.material_id)
+        state_changes |= SCENE_MATERIAL_CHANGE;
+    return state_changes;
+}
+
+////////////////////////////////////////////////////////////////////////
+void generate_model(const RenderingConfig& in_rendering_config, RenderingData& out_rendering_data)
+{
+    out_rendering_data.setup_times.generate_model = 0;
+    ScopedTimer timer(out_rendering_data.setup_times.generate_model);
+    ScopedTrace trace("generate_model");
+
+    out_rendering_data.model_nb_triangles = nb_mesh_triangles(in_rendering_config);
+    out_rendering_data.model_in_memory = model_kept_in_memory(in_rendering_config);
+
+    if (out_rendering_data.model_in_memory)
+    {
+        generate_geometry(out_rendering_data.model_nb_triangles, out_rendering_data.geometry);
+        compute_normals(out_rendering_data.geometry);
+    }
+    else
+    {
+        // Only the chunks of a streamed model are ever in memory, a procedural model not even them, release the previous model
+        out_rendering_data.geometry = Geometry();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+GLenum texture_internal_format(TextureFormat in_texture_format)
+{
+    if (in_texture_format == TEXTURE_COMPRESSED)
+    {
+        return is_gl_extension_supported("GL_EXT_texture_compression_s3tc") ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA;
+    }
+    else if (in_texture_format == TEXTURE_FLOAT && is_gl_extension_supported("GL_ARB_texture_float"))
+    {
+        return GL_RGBA32F_ARB;
+    }
+    return GL_RGBA8;
+}
+
+////////////////////////////////////////////////////////////////////////
+GLenum texture_pixel_type(TextureFormat in_texture_format)
+{
+    return (in_texture_format == TEXTURE_FLOAT) ? GL_FLOAT : GL_UNSIGNED_BYTE;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int texture_pixel_size(TextureFormat in_texture_format)
+{
+    return 4 * ((in_texture_format == TEXTURE_FLOAT) ? sizeof(GLfloat) : sizeof(GLubyte));
+}
+
+////////////////////////////////////////////////////////////////////////
+void generate_texture(unsigned int in_texture_size, TextureFormat in_texture_format, std::vector<unsigned char>& out_texture_data)
+{
+    // Checkerboard of 2x2 cells, whatever the size : the model looks the same for every texture size
+    const unsigned int cell_size = (in_texture_size > 1) ? in_texture_size / 2 : 1;
+    const unsigned int pixel_size = texture_pixel_size(in_texture_format);
+
+    out_texture_data.resize(static_cast<size_t>(in_texture_size) * in_texture_size * pixel_size);
+
+    size_t offset = 0;
+    for (unsigned int y = 0; y < in_texture_size; ++y)
+    {
+        for (unsigned int x = 0; x < in_texture_size; ++x)
+        {
+            const bool white = ((x / cell_size) + (y / cell_size)) % 2 == 0;
+            if (in_texture_format == TEXTURE_FLOAT)
+            {
+                const GLfloat value = white ? 1.0f : 0.0f;
+                const GLfloat texel[4] = { value, value, value, 0.0f };
+                memcpy(&out_texture_data[offset], texel, sizeof(texel));
+            }
+            else
+            {
+                const GLubyte value = white ? 0xFF : 0;
+                const GLubyte texel[4] = { value, value, value, 0 };
+                memcpy(&out_texture_data[offset], texel, sizeof(texel));
+            }
+            offset += pixel_size;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_texturing(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    io_rendering_data.setup_times.texturing = 0;
+    ScopedTimer timer(io_rendering_data.setup_times.texturing);
+
+    delete_texturing(io_rendering_data);
+
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+    {
+        glGenTextures(1, &io_rendering_data.texture_id);
+        glBindTexture(GL_TEXTURE_2D, io_rendering_data.texture_id);
+        if (in_rendering_config.texture_filter == TEXTURE_NEAREST)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        else
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+        }
+        if (in_rendering_config.texture_filter == TEXTURE_ANISOTROPIC && is_gl_extension_supported("GL_EXT_texture_filter_anisotropic"))
+        {
+            GLfloat max_anisotropy = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_anisotropy);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        std::vector<unsigned char> texture_data;
+        generate_texture(in_rendering_config.texture_size, in_rendering_config.texture_format, texture_data);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, texture_internal_format(in_rendering_config.texture_format),
+                     in_rendering_config.texture_size, in_rendering_config.texture_size, 0,
+                     GL_RGBA, texture_pixel_type(in_rendering_config.texture_format), &texture_data[0]);
+        glFinish();     // upload and mipmap generation are part of the setup time
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_texturing(RenderingData& io_rendering_data)
+{
+    if (io_rendering_data.texture_id)
+    {
+        glDeleteTextures(1, &io_rendering_data.texture_id);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        io_rendering_data.texture_id = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+bool compress_texture(unsigned int in_texture_size, const std::vector<unsigned char>& in_texture_data, std::vector<unsigned char>& out_compressed_data, GLenum& out_compressed_format)
+{
+    // The driver compresses the texels once, the upload bench then only transfers compressed blocks
+    GLuint texture_id = 0;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, texture_internal_format(TEXTURE_COMPRESSED), in_texture_size, in_texture_size, 0,
+                 GL_RGBA, texture_pixel_type(TEXTURE_COMPRESSED), &in_texture_data[0]);
+
+    GLint compressed = GL_FALSE;
+    GLint compressed_format = 0;
+    GLint compressed_size = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &compressed_format);    // the actual format of a generic one
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+
+    const bool success = (compressed == GL_TRUE && compressed_size > 0);
+    if (success)
+    {
+        out_compressed_data.resize(compressed_size);
+        glGetCompressedTexImage(GL_TEXTURE_2D, 0, &out_compressed_data[0]);
+        out_compressed_format = compressed_format;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture_id);
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////
+double upload_texture(TextureUploadMethod in_upload_method, unsigned int in_texture_size, TextureFormat in_texture_format, GLenum in_internal_format, const std::vector<unsigned char>& in_texture_data)
+{
+    // Compressed textures upload compressed blocks, the bandwidth counts their size
+    const size_t nb_bytes = in_texture_data.size();
+    const bool compressed = (in_texture_format == TEXTURE_COMPRESSED);
+    const GLenum pixel_type = texture_pixel_type(in_texture_format);
+
+    unsigned int nb_uploads = TEXTURE_UPLOAD_MIN_BYTES / nb_bytes;
+    if (nb_uploads < TEXTURE_UPLOAD_MIN_COUNT)
+    {
+        nb_uploads = TEXTURE_UPLOAD_MIN_COUNT;
+    }
+
+    while (glGetError() != GL_NO_ERROR) {}  // do not blame the upload for older errors
+
+    GLuint texture_id = 0;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    if (compressed)
+    {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, in_internal_format, in_texture_size, in_texture_size, 0, nb_bytes, &in_texture_data[0]);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, in_internal_format, in_texture_size, in_texture_size, 0, GL_RGBA, pixel_type, NULL);
+    }
+
+    // Two pixel buffers : the copy into one overlaps the transfer from the other
+    GLuint pixel_buffer_ids[2] = { 0, 0 };
+    if (in_upload_method == PBO_UPLOAD)
+    {
+        glGenBuffers(2, pixel_buffer_ids);
+    }
+
+    struct timeval start;
+    struct timeval end;
+
+    glFinish();
+    gettimeofday(&start, NULL);
+
+    for (unsigned int i = 0; i < nb_uploads; ++i)
+    {
+        if (in_upload_method == TEX_IMAGE_UPLOAD && compressed)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, 0, in_internal_format, in_texture_size, in_texture_size, 0, nb_bytes, &in_texture_data[0]);
+        }
+        else if (in_upload_method == TEX_IMAGE_UPLOAD)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, in_internal_format, in_texture_size, in_texture_size, 0, GL_RGBA, pixel_type, &in_texture_data[0]);
+        }
+        else if (in_upload_method == TEX_SUB_IMAGE_UPLOAD && compressed)
+        {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, in_texture_size, in_texture_size, in_internal_format, nb_bytes, &in_texture_data[0]);
+        }
+        else if (in_upload_method == TEX_SUB_IMAGE_UPLOAD)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, in_texture_size, in_texture_size, GL_RGBA, pixel_type, &in_texture_data[0]);
+        }
+        else if (in_upload_method == PBO_UPLOAD)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer_ids[i % 2]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, nb_bytes, NULL, GL_STREAM_DRAW);   // orphan the previous storage, no wait on the GPU
+            void* p_pixel_buffer = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+            if (p_pixel_buffer)
+            {
+                memcpy(p_pixel_buffer, &in_texture_data[0], nb_bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            if (compressed)
+            {
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, in_texture_size, in_texture_size, in_internal_format, nb_bytes, BUFFER_OFFSET_CAST(0));
+            }
+            else
+            {
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, in_texture_size, in_texture_size, GL_RGBA, pixel_type, BUFFER_OFFSET_CAST(0));
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+
+    glFinish();
+    gettimeofday(&end, NULL);
+
+    const bool upload_error = (glGetError() != GL_NO_ERROR);
+
+    if (in_upload_method == PBO_UPLOAD)
+    {
+        glDeleteBuffers(2, pixel_buffer_ids);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture_id);
+
+    const long upload_time = elapsed_time_us(start, end);
+    if (upload_error || upload_time <= 0)
+    {
+        return -1.0;
+    }
+    return static_cast<double>(nb_bytes) * nb_uploads / static_cast<double>(upload_time);  // bytes per us == MB/s
+}
+
+////////////////////////////////////////////////////////////////////////
+void bench_texture_upload(std::ostream& out_stream)
+{
+    out_stream << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Texture upload bandwidth (MB/s, of compressed data for the compressed format)" << std::endl;
+
+    for (unsigned int texture_size_id = 0; texture_size_id < NB_TEXTURE_SIZES; ++texture_size_id)
+    {
+        const unsigned int texture_size = TEXTURE_SIZES[texture_size_id];
+        if (texture_size < TEXTURE_UPLOAD_MIN_SIZE)
+        {
+            continue;
+        }
+
+        for (unsigned int texture_format = TEXTURE_RGBA8; texture_format < NB_TEXTURE_FORMAT; ++texture_format)
+        {
+            std::vector<unsigned char> texture_data;
+            generate_texture(texture_size, static_cast<TextureFormat>(texture_format), texture_data);
+
+            // Compressed out of the timed uploads, so that the driver's compression is not part of the bandwidth
+            GLenum internal_format = texture_internal_format(static_cast<TextureFormat>(texture_format));
+            bool supported = true;
+            if (texture_format == TEXTURE_COMPRESSED)
+            {
+                std::vector<unsigned char> compressed_data;
+                supported = compress_texture(texture_size, texture_data, compressed_data, internal_format);
+                texture_data.swap(compressed_data);
+            }
+
+            out_stream << " - " << texture_size << "x" << texture_size << " " << texture_format_name(static_cast<TextureFormat>(texture_format)) << " :";
+
+            for (unsigned int upload_method = TEX_IMAGE_UPLOAD; upload_method < NB_TEXTURE_UPLOAD_METHOD; ++upload_method)
+            {
+                const double bandwidth = supported ? upload_texture(static_cast<TextureUploadMethod>(upload_method), texture_size, static_cast<TextureFormat>(texture_format),
+                                                                    internal_format, texture_data) : -1.0;
+
+                out_stream << " " << texture_upload_method_name(static_cast<TextureUploadMethod>(upload_method)) << " ";
+                if (bandwidth < 0.0)
+                    out_stream << "unsupported";
+                else
+                    out_stream << static_cast<unsigned int>(bandwidth + 0.5);
+            }
+            out_stream << std::endl;
+            std::cout << '.' << std::flush;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void bench_thread_scaling(std::ostream& out_stream, const RenderingData& in_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config)
+{
+    out_stream << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Thread scaling : " << THREAD_BENCH_NB_FRAMES << " frames per thread, one context and framebuffer each" << std::endl;
+
+    Display* p_display = glXGetCurrentDisplay();
+    const GLXContext main_context = glXGetCurrentContext();
+
+    const int fb_attributes[] = {GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT, GLX_RENDER_TYPE, GLX_RGBA_BIT,
+                                 GLX_RED_SIZE, 8, GLX_GREEN_SIZE, 8, GLX_BLUE_SIZE, 8, GLX_DEPTH_SIZE, 24, None};
+    int nb_fb_configs = 0;
+    GLXFBConfig* p_fb_configs = glXChooseFBConfig(p_display, DefaultScreen(p_display), fb_attributes, &nb_fb_configs);
+    if (p_fb_configs == NULL || nb_fb_configs == 0)
+    {
+        out_stream << " pbuffer contexts are not supported" << std::endl;
+        return;
+    }
+
+    // Every thread renders the current config offscreen, at the window size unless an offscreen size is set
+    RenderingConfig rendering_config = in_rendering_config;
+    rendering_config.readback_mode = NO_READBACK;
+    rendering_config.rendering_options.reset(CAPTURE);
+    if (rendering_config.framebuffer_width == 0 || rendering_config.framebuffer_height == 0)
+    {
+        rendering_config.framebuffer_width  = in_display_config.windows_width;
+        rendering_config.framebuffer_height = in_display_config.windows_height;
+    }
+    const int pbuffer_attributes[] = {GLX_PBUFFER_WIDTH, static_cast<int>(rendering_config.framebuffer_width),
+                                      GLX_PBUFFER_HEIGHT, static_cast<int>(rendering_config.framebuffer_height), None};
+    const double nb_triangles = static_cast<double>(THREAD_BENCH_NB_FRAMES) * frame_nb_triangles(rendering_config);
+
+    // Spans would be recorded from several threads
+    const bool trace_enabled = trace_data.enabled;
+    trace_data.enabled = false;
+
+    for (unsigned int shared_objects = 0; shared_objects < 2; ++shared_objects)
+    {
+        out_stream << (shared_objects ? " Objects shared with the main context (Mtri/s)" : " Objects created by each thread (Mtri/s)") << std::endl;
+
+        double single_thread_throughput = 0.0;
+        for (unsigned int thread_count_id = 0; thread_count_id < NB_THREAD_COUNTS; ++thread_count_id)
+        {
+            const unsigned int nb_threads = THREAD_COUNTS[thread_count_id];
+
+            std::vector<ThreadBenchWorker> workers(nb_threads);
+            std::vector<SDL_Thread*> threads(nb_threads, static_cast<SDL_Thread*>(NULL));
+            SDL_sem* p_ready_semaphore = SDL_CreateSemaphore(0);
+            SDL_sem* p_start_semaphore = SDL_CreateSemaphore(0);
+
+            // Contexts are created here, each thread makes its own current
+            for (unsigned int i = 0; i < nb_threads; ++i)
+            {
+                ThreadBenchWorker& worker = workers[i];
+                worker.p_display = p_display;
+                worker.pbuffer = glXCreatePbuffer(p_display, p_fb_configs[0], pbuffer_attributes);
+                worker.context = glXCreateNewContext(p_display, p_fb_configs[0], GLX_RGBA_TYPE, shared_objects ? main_context : NULL, True);
+                worker.p_main_rendering_data = &in_rendering_data;
+                worker.shared_objects = shared_objects;
+                worker.display_config = in_display_config;
+                worker.rendering_config = rendering_config;
+                worker.p_ready_semaphore = p_ready_semaphore;
+                worker.p_start_semaphore = p_start_semaphore;
+                worker.success = false;
+                worker.rendering_time = 0;
+            }
+            unsigned int nb_started_threads = 0;
+            for (unsigned int i = 0; i < nb_threads; ++i)
+            {
+                threads[i] = SDL_CreateThread(thread_bench_worker, &workers[i]);
+                nb_started_threads += threads[i] ? 1 : 0;
+            }
+
+            // Start every thread at once, after their setup
+            for (unsigned int i = 0; i < nb_started_threads; ++i)
+            {
+                SDL_SemWait(p_ready_semaphore);
+            }
+            struct timeval start;
+            struct timeval end;
+            gettimeofday(&start, NULL);
+            for (unsigned int i = 0; i < nb_started_threads; ++i)
+            {
+                SDL_SemPost(p_start_semaphore);
+            }
+            for (unsigned int i = 0; i < nb_threads; ++i)
+            {
+                if (threads[i])
+                {
+                    SDL_WaitThread(threads[i], NULL);
+                }
+            }
+            gettimeofday(&end, NULL);
+
+            bool success = true;
+            double min_throughput = 0.0;
+            double max_throughput = 0.0;
+            double sum_throughput = 0.0;
+            for (unsigned int i = 0; i < nb_threads; ++i)
+            {
+                const ThreadBenchWorker& worker = workers[i];
+                success = success && worker.success && worker.rendering_time > 0;
+                const double throughput = (worker.rendering_time > 0) ? nb_triangles / worker.rendering_time : 0.0;
+                min_throughput = (i == 0) ? throughput : std::min(min_throughput, throughput);
+                max_throughput = (i == 0) ? throughput : std::max(max_throughput, throughput);
+                sum_throughput += throughput;
+
+                glXDestroyContext(p_display, worker.context);
+                glXDestroyPbuffer(p_display, worker.pbuffer);
+            }
+            SDL_DestroySemaphore(p_ready_semaphore);
+            SDL_DestroySemaphore(p_start_semaphore);
+
+            out_stream << " - " << nb_threads << " thread(s) : ";
+            if (!success)
+            {
+                out_stream << "thread or context creation failed" << std::endl;
+                continue;
+            }
+            const double aggregate_throughput = nb_threads * nb_triangles / elapsed_time_us(start, end);
+            if (nb_threads == 1)
+            {
+                single_thread_throughput = aggregate_throughput;
+            }
+            out_stream << "aggregate ";
+            print_fixed(out_stream, aggregate_throughput, 2);
+            out_stream << ", per thread ";
+            print_fixed(out_stream, min_throughput, 2);
+            out_stream << " / ";
+            print_fixed(out_stream, sum_throughput / nb_threads, 2);
+            out_stream << " / ";
+            print_fixed(out_stream, max_throughput, 2);
+            out_stream << " (min / mean / max)";
+            if (single_thread_throughput > 0.0)
+            {
+                out_stream << ", scaling x";
+                print_fixed(out_stream, aggregate_throughput / single_thread_throughput, 2);
+            }
+#ifdef GLBENCH_GL_COUNTERS
+            GlCounters thread_gl_counters;
+            clear_gl_counters(thread_gl_counters);
+            for (unsigned int i = 0; i < nb_threads; ++i)
+            {
+                add_gl_counters(thread_gl_counters, workers[i].gl_counters);
+            }
+            print_thread_gl_counters(out_stream, thread_gl_counters);
+#endif
+            out_stream << std::endl;
+            std::cout << '.' << std::flush;
+        }
+    }
+
+    trace_data.enabled = trace_enabled;
+    XFree(p_fb_configs);
+}
+
+////////////////////////////////////////////////////////////////////////
+int thread_bench_worker(void* io_p_worker)
+{
+    ThreadBenchWorker& worker = *static_cast<ThreadBenchWorker*>(io_p_worker);
+    const RenderingConfig& rendering_config = worker.rendering_config;
+
+    worker.success = worker.pbuffer && worker.context && glXMakeContextCurrent(worker.p_display, worker.pbuffer, worker.pbuffer, worker.context);
+
+    RenderingData rendering_data;
+    init_rendering_data(rendering_data, worker.display_config);
+    if (worker.success)
+    {
+        // The model of the main context is read only while the workers run, no copy per thread
+        rendering_data.p_shared_geometry = &model_geometry(*worker.p_main_rendering_data);
+        rendering_data.model_nb_triangles = worker.p_main_rendering_data->model_nb_triangles;
+
+        if (worker.shared_objects)
+        {
+            // Framebuffers are never shared, the other objects come from the main context
+            process_framebuffer(rendering_data, worker.display_config, rendering_config);
+            glViewport(0 , 0, static_cast<GLsizei>(rendering_data.rendering_width), static_cast<GLsizei>(rendering_data.rendering_height));
+            set_gl_state(rendering_config);
+            process_streaming(rendering_data, rendering_config);     // the ring is written by each thread
+            process_culling(rendering_data, rendering_config);       // and the draw commands
+            process_scene(rendering_data, rendering_config);
+
+            rendering_data.procedural = worker.p_main_rendering_data->procedural;
+            rendering_data.texture_id = worker.p_main_rendering_data->texture_id;
+            rendering_data.call_list_id = worker.p_main_rendering_data->call_list_id;
+            rendering_data.nb_call_lists = worker.p_main_rendering_data->nb_call_lists;
+            rendering_data.vertex_buffer_id = worker.p_main_rendering_data->vertex_buffer_id;
+            rendering_data.index_buffer_id = worker.p_main_rendering_data->index_buffer_id;
+            glBindTexture(GL_TEXTURE_2D, rendering_data.texture_id);
+            if (rendering_data.vertex_buffer_id)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, rendering_data.vertex_buffer_id);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rendering_data.index_buffer_id);
+                enable_vbo_client_state(rendering_config);
+            }
+        }
+        else
+        {
+            init_gl(rendering_data, worker.display_config, rendering_config);
+        }
+
+        // First frame out of the measure
+        render(rendering_data, rendering_config, worker.display_config);
+        glFinish();
+    }
+
+    SDL_SemPost(worker.p_ready_semaphore);
+    SDL_SemWait(worker.p_start_semaphore);
+
+    if (worker.success)
+    {
+        struct timeval start;
+        struct timeval end;
+        GL_COUNTERS_BEGIN_THREAD();
+        gettimeofday(&start, NULL);
+        for (unsigned int i = 0; i < THREAD_BENCH_NB_FRAMES; ++i)
+        {
+            render(rendering_data, rendering_config, worker.display_config);
+            GL_COUNTERS_END_FRAME();
+        }
+        glFinish();
+        gettimeofday(&end, NULL);
+        worker.rendering_time = elapsed_time_us(start, end);
+
+        // Objects of the main context stay alive
+        if (worker.shared_objects)
+        {
+            rendering_data.texture_id = 0;
+            rendering_data.call_list_id = 0;
+            rendering_data.vertex_buffer_id = 0;
+            rendering_data.index_buffer_id = 0;
+            rendering_data.procedural.program_id = 0;
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        delete_call_list(rendering_data);
+        delete_vbo(rendering_data);
+        delete_streaming(rendering_data);
+        delete_procedural(rendering_data);
+        delete_culling(rendering_data);
+        delete_texturing(rendering_data);
+        delete_framebuffer(rendering_data);
+        glXMakeContextCurrent(worker.p_display, None, None, NULL);
+    }
+    GL_COUNTERS_END_THREAD(worker.gl_counters);
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+bool bench_validation(std::ostream& out_stream, RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config)
+{
+    out_stream << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Validation against the immediate mode : " << VALIDATION_FRAMEBUFFER_SIZE << "x" << VALIDATION_FRAMEBUFFER_SIZE
+               << ", PSNR >= " << VALIDATION_MIN_PSNR << " dB" << std::endl;
+
+    // Same fixed view for every config
+    DisplayConfig display_config = in_display_config;
+    display_config.rotation_angle_x = default_rotation_angle_x;
+    display_config.rotation_angle_y = default_rotation_angle_y;
+    display_config.move_forward = default_move_forward;
+
+    RenderingConfig rendering_config = in_rendering_config;
+    rendering_config.framebuffer_width  = VALIDATION_FRAMEBUFFER_SIZE;
+    rendering_config.framebuffer_height = VALIDATION_FRAMEBUFFER_SIZE;
+    rendering_config.readback_mode = NO_READBACK;
+    rendering_config.rendering_options.reset(CAPTURE);
+
+    unsigned int nb_mismatches = 0;
+    for (unsigned int rendering_options = 0 ; rendering_options != (1U << NB_BENCH_RENDERING_OPTION); ++rendering_options)
+    {
+        for (unsigned int i = 0; i < NB_BENCH_RENDERING_OPTION; ++i)
+        {
+            rendering_config.rendering_options.set(i, (rendering_options >> i) & 1);
+        }
+
+        std::vector<unsigned char> reference_pixels;
+        for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+        {
+            rendering_config.rendering_method = static_cast<RenderingMethod>(rendering_method);
+
+            init_gl(io_rendering_data, display_config, rendering_config);
+            render(io_rendering_data, rendering_config, display_config);
+
+            std::vector<unsigned char> pixels;
+            read_frame(io_rendering_data, pixels);
+            if (rendering_method == IMMEDIATE)
+            {
+                reference_pixels.swap(pixels);
+                continue;
+            }
+
+            unsigned int nb_different_pixels = 0;
+            const double psnr = image_psnr(reference_pixels, pixels, nb_different_pixels);
+            const bool valid = (psnr >= VALIDATION_MIN_PSNR);
+            nb_mismatches += valid ? 0 : 1;
+
+            print_config(rendering_config, out_stream);
+            out_stream << (valid ? "| pass" : "| FAIL") << " : PSNR ";
+            if (psnr == HUGE_VAL)
+                out_stream << "inf";
+            else
+                print_fixed(out_stream, psnr, 1);
+            out_stream << " dB, " << nb_different_pixels << " different pixels" << std::endl;
+        }
+        std::cout << '.' << std::flush;
+    }
+
+    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
+    out_stream << " Validation " << (nb_mismatches ? "FAILED : " : "passed : ") << nb_mismatches << " config(s) differ from the immediate mode" << std::endl;
+    return nb_mismatches == 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void read_frame(const RenderingData& in_rendering_data, std::vector<unsigned char>& out_pixels)
+{
+    // Offscreen framebuffer when it is supported, back buffer of the window otherwise
+    out_pixels.resize(static_cast<size_t>(in_rendering_data.rendering_width) * in_rendering_data.rendering_height * 4);
+    glReadBuffer(in_rendering_data.framebuffer_id ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, in_rendering_data.rendering_width, in_rendering_data.rendering_height, GL_RGBA, GL_UNSIGNED_BYTE, &out_pixels[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+double image_psnr(const std::vector<unsigned char>& in_reference_pixels, const std::vector<unsigned char>& in_pixels, unsigned int& out_nb_different_pixels)
+{
+    out_nb_different_pixels = 0;
+    if (in_reference_pixels.size() != in_pixels.size() || in_pixels.empty())
+    {
+        return 0.0;
+    }
+
+    // RGB only, alpha is not displayed
+    double squared_error_sum = 0.0;
+    for (size_t i = 0; i < in_pixels.size(); i += 4)
+    {
+        bool different = false;
+        for (size_t j = i; j < i + 3; ++j)
+        {
+            const int difference = static_cast<int>(in_pixels[j]) - static_cast<int>(in_reference_pixels[j]);
+            squared_error_sum += difference * difference;
+            different = different || abs(difference) > VALIDATION_PIXEL_TOLERANCE;
+        }
+        out_nb_different_pixels += different ? 1 : 0;
+    }
+    if (squared_error_sum == 0.0)
+    {
+        return HUGE_VAL;
+    }
+    const double mean_squared_error = squared_error_sum / (in_pixels.size() / 4 * 3);
+    return 10.0 * log10(255.0 * 255.0 / mean_squared_error);
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_call_list(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    io_rendering_data.setup_times.call_list = 0;
+    ScopedTimer timer(io_rendering_data.setup_times.call_list);
+
+    delete_call_list(io_rendering_data);
+
+    if (in_rendering_config.rendering_method == CALL_LIST)
+    {
+        // Lists live in the driver, their size is the process memory they take
+        size_t rss_before = 0;
+        size_t rss_after = 0;
+        size_t peak_rss = 0;
+        read_process_memory(rss_before, peak_rss);
+
+        if (in_rendering_config.call_list_build == REPLAY_CALL_LIST)
+        {
+            io_rendering_data.call_list_id = glGenLists(1);
+            io_rendering_data.nb_call_lists = 1;
+            glNewList(io_rendering_data.call_list_id, GL_COMPILE);
+            paint_gl(model_geometry(io_rendering_data), in_rendering_config);
+            glEndList();
+        }
+        else
+        {
+            compile_vertex_array_call_lists(io_rendering_data, in_rendering_config);
+        }
+        glFinish();
+
+        read_process_memory(rss_after, peak_rss);
+        io_rendering_data.call_list_size = (rss_after > rss_before) ? rss_after - rss_before : 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void compile_vertex_array_call_lists(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    const Geometry& geometry = model_geometry(io_rendering_data);
+
+    // Interleaved float arrays in client memory, dereferenced by glDrawElements when the list is compiled
+    std::vector<GLfloat> vertex_buffer(static_cast<size_t>(geometry.vertices.size()) * nb_vertex_floats(in_rendering_config));
+    std::vector<GLuint> index_buffer(count_indices(geometry, in_rendering_config));
+    if (vertex_buffer.empty() || index_buffer.empty())
+    {
+        return;
+    }
+    pack_vertex_buffer(geometry, in_rendering_config, 0, geometry.vertices.size(), &vertex_buffer[0]);
+    pack_index_buffer(geometry, in_rendering_config, &index_buffer[0]);
+
+    // Pointers are offsets in the bound buffers otherwise, the VBO of the previous config is deleted afterwards
+    if (glBindBuffer)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    const GLsizei stride = nb_vertex_floats(in_rendering_config) * sizeof(GLfloat);
+    unsigned int offset = 0;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, &vertex_buffer[offset]);
+    offset += 3;
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, stride, &vertex_buffer[offset]);
+    offset += 3;
+    if (in_rendering_config.rendering_options.test(COLOR))
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_FLOAT, stride, &vertex_buffer[offset]);
+        offset += 3;
+    }
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(3, GL_FLOAT, stride, &vertex_buffer[offset]);
+        offset += 3;
+    }
+
+    const bool strip_lists = (in_rendering_config.call_list_build == STRIP_CALL_LISTS);
+    const GLenum list_mode = (in_rendering_config.call_list_build == COMPILE_AND_EXECUTE_CALL_LIST) ? GL_COMPILE_AND_EXECUTE : GL_COMPILE;
+    const GLenum primitive = in_rendering_config.rendering_options.test(TRIANGLE_STRIP) ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+
+    io_rendering_data.nb_call_lists = strip_lists ? geometry.triangles_strip.size() : 1;
+    io_rendering_data.call_list_id = glGenLists(io_rendering_data.nb_call_lists);
+
+    unsigned int first_index = 0;
+    unsigned int list_id = 0;
+    if (!strip_lists)
+    {
+        glNewList(io_rendering_data.call_list_id, list_mode);
+        if (!in_rendering_config.rendering_options.test(COLOR))
+        {
+            glColor3d(1.0, 1.0, 1.0);
+        }
+    }
+    for (std::list<TriangleStrip>::const_iterator it = geometry.triangles_strip.begin(); it != geometry.triangles_strip.end(); ++it)
+    {
+        const unsigned int nb_strip_indices = count_strip_indices(*it, in_rendering_config);
+        if (strip_lists)
+        {
+            glNewList(io_rendering_data.call_list_id + list_id, list_mode);
+            if (!in_rendering_config.rendering_options.test(COLOR))
+            {
+                glColor3d(1.0, 1.0, 1.0);
+            }
+        }
+        glDrawElements(primitive, nb_strip_indices, GL_UNSIGNED_INT, &index_buffer[first_index]);
+        if (strip_lists)
+        {
+            glEndList();
+        }
+        first_index += nb_strip_indices;
+        ++list_id;
+    }
+    if (!strip_lists)
+    {
+        glEndList();
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_call_list(RenderingData& io_rendering_data)
+{
+    if (io_rendering_data.call_list_id)
+    {
+        glDeleteLists(io_rendering_data.call_list_id, io_rendering_data.nb_call_lists);
+        io_rendering_data.call_list_id = 0;
+        io_rendering_data.nb_call_lists = 0;
+    }
+    io_rendering_data.call_list_size = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void upload_vertex_buffer(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, GLenum in_usage)
+{
+    const unsigned int nb_vertices = model_geometry(io_rendering_data).vertices.size();
+    const unsigned int vertex_data_size = nb_vertex_floats(in_rendering_config);
+    io_rendering_data.vertex_buffer_size = static_cast<size_t>(nb_vertices) * vertex_data_size * sizeof(GLfloat);
+
+    glGenBuffers(1, &io_rendering_data.vertex_buffer_id);
+    glBindBuffer(GL_ARRAY_BUFFER, io_rendering_data.vertex_buffer_id);
+
+    if (in_rendering_config.rendering_options.test(CHUNKED_UPLOAD))
+    {
+        // Allocate the buffer, then fill it chunk by chunk from a small staging buffer
+        glBufferData(GL_ARRAY_BUFFER, io_rendering_data.vertex_buffer_size, NULL, in_usage);
+
+        std::vector<GLfloat> staging_buffer(UPLOAD_CHUNK_NB_VERTICES * vertex_data_size);
+        for (unsigned int first_vertex = 0; first_vertex < nb_vertices; first_vertex += UPLOAD_CHUNK_NB_VERTICES)
+        {
+            const unsigned int nb_chunk_vertices = std::min(UPLOAD_CHUNK_NB_VERTICES, nb_vertices - first_vertex);
+            {
+                ScopedTimer timer(io_rendering_data.setup_times.vbo_packing);
+                pack_vertex_buffer(model_geometry(io_rendering_data), in_rendering_config, first_vertex, nb_chunk_vertices, &staging_buffer[0]);
+            }
+            {
+                ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+                glBufferSubData(GL_ARRAY_BUFFER, static_cast<size_t>(first_vertex) * vertex_data_size * sizeof(GLfloat),
+                                static_cast<size_t>(nb_chunk_vertices) * vertex_data_size * sizeof(GLfloat), &staging_buffer[0]);
+            }
+        }
+        ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+        glFinish();
+    }
+    else
+    {
+        // Whole interleaved copy of the model, then a single upload
+        GLfloat *p_vertex_buffer = new GLfloat[static_cast<size_t>(nb_vertices) * vertex_data_size];
+        {
+            ScopedTimer timer(io_rendering_data.setup_times.vbo_packing);
+            pack_vertex_buffer(model_geometry(io_rendering_data), in_rendering_config, 0, nb_vertices, p_vertex_buffer);
+        }
+        {
+            ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+            glBufferData(GL_ARRAY_BUFFER, io_rendering_data.vertex_buffer_size, p_vertex_buffer, in_usage);
+            glFinish();
+        }
+        delete [] p_vertex_buffer;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void upload_index_buffer(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, GLenum in_usage)
+{
+    const Geometry& geometry = model_geometry(io_rendering_data);
+    const unsigned int nb_index = count_indices(geometry, in_rendering_config);
+    io_rendering_data.index_buffer_size = static_cast<size_t>(nb_index) * sizeof(GLuint);
+
+    glGenBuffers(1, &io_rendering_data.index_buffer_id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, io_rendering_data.index_buffer_id);
+
+    if (in_rendering_config.rendering_options.test(CHUNKED_UPLOAD))
+    {
+        // Allocate the buffer, then fill it with as many whole strips as the staging buffer holds
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, io_rendering_data.index_buffer_size, NULL, in_usage);
+
+        std::vector<GLuint> staging_buffer(UPLOAD_CHUNK_NB_INDICES);
+        size_t uploaded_size = 0;
+        unsigned int nb_staged_indices = 0;
+
+        std::list<TriangleStrip>::const_iterator it = geometry.triangles_strip.begin();
+        while (it != geometry.triangles_strip.end() || nb_staged_indices)
+        {
+            const bool last_strip = (it == geometry.triangles_strip.end());
+            const unsigned int nb_strip_indices = last_strip ? 0 : count_strip_indices(*it, in_rendering_config);
+
+            if (!last_strip && nb_staged_indices + nb_strip_indices <= staging_buffer.size())
+            {
+                ScopedTimer timer(io_rendering_data.setup_times.vbo_packing);
+                nb_staged_indices += pack_strip_indices(*it, in_rendering_config, &staging_buffer[nb_staged_indices]);
+                ++it;
+            }
+            else if (nb_staged_indices)
+            {
+                ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, uploaded_size, nb_staged_indices * sizeof(GLuint), &staging_buffer[0]);
+                uploaded_size += nb_staged_indices * sizeof(GLuint);
+                nb_staged_indices = 0;
+            }
+            else
+            {
+                staging_buffer.resize(nb_strip_indices);    // strip larger than the staging buffer
+            }
+        }
+        ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+        glFinish();
+    }
+    else
+    {
+        // Whole index copy of the model, then a single upload
+        GLuint *p_index_buffer = new GLuint[nb_index];
+        {
+            ScopedTimer timer(io_rendering_data.setup_times.vbo_packing);
+            pack_index_buffer(geometry, in_rendering_config, p_index_buffer);
+        }
+        {
+            ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, io_rendering_data.index_buffer_size, p_index_buffer, in_usage);
+            glFinish();
+        }
+        delete[] p_index_buffer;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void enable_vbo_client_state(const RenderingConfig& in_rendering_config)
+{
+    const unsigned int vertex_data_size = nb_vertex_floats(in_rendering_config);
+
+    // Enable client state
+    unsigned int buffer_offset = 0;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
+    buffer_offset += 12;
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
+    buffer_offset += 12;
+    if (in_rendering_config.rendering_options.test(COLOR))
+    {
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
+        buffer_offset += 12;
+    }
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+    {
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glTexCoordPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
+        buffer_offset += 12;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_vbo(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    io_rendering_data.setup_times.vbo_packing = 0;
+    io_rendering_data.setup_times.vbo_upload = 0;
+
+    delete_vbo(io_rendering_data);
+
+    if (in_rendering_config.rendering_method == STATIC_VBO || in_rendering_config.rendering_method == DYNAMIC_VBO
+        ||
+        in_rendering_config.rendering_method == GPU_CULLED)
+    {
+        const GLenum gl_draw_method = (in_rendering_config.rendering_method == DYNAMIC_VBO) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+
+        // VBO
+        upload_vertex_buffer(io_rendering_data, in_rendering_config, gl_draw_method);
+
+        // IBO
+        upload_index_buffer(io_rendering_data, in_rendering_config, gl_draw_method);
+
+        enable_vbo_client_state(in_rendering_config);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_vbo(RenderingData& io_rendering_data)
+{
+    if (io_rendering_data.vertex_buffer_id || io_rendering_data.index_buffer_id)
+    {
+        if (io_rendering_data.vertex_buffer_id) // vbo
+        {
+            // Disable client state
+            glDisableClientState(GL_VERTEX_ARRAY);
+            glDisableClientState(GL_COLOR_ARRAY);
+            glDisableClientState(GL_NORMAL_ARRAY);
+            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+            // Unbind and delete buffer
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &io_rendering_data.vertex_buffer_id);
+            io_rendering_data.vertex_buffer_id = 0;
+            io_rendering_data.vertex_buffer_size = 0;
+        }
+        if (io_rendering_data.index_buffer_id)  // ibo
+        {
+            // Unbind and delete buffer
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &io_rendering_data.index_buffer_id);
+            io_rendering_data.index_buffer_id = 0;
+            io_rendering_data.index_buffer_size = 0;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_streaming(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    delete_streaming(io_rendering_data);
+
+    StreamingData& streaming_data = io_rendering_data.streaming;
+    clear_streaming_stats(streaming_data);
+
+    if (in_rendering_config.rendering_method == STREAMING_VBO)
+    {
+        streaming_data.nb_subdivisions = nb_grid_subdivisions(io_rendering_data.model_nb_triangles);
+        streaming_data.nb_chunk_rows = std::max(1U, std::min(streaming_data.nb_subdivisions, STREAMING_CHUNK_NB_TRIANGLES / std::max(1U, 2 * streaming_data.nb_subdivisions)));
+        streaming_data.next_buffer = 0;
+
+        // Every buffer pair holds the largest chunk
+        const unsigned int row_size = streaming_data.nb_subdivisions + 1;
+        const unsigned int nb_strip_indices = in_rendering_config.rendering_options.test(TRIANGLE_STRIP) ? 2 * row_size : 6 * streaming_data.nb_subdivisions;
+        const size_t vertex_buffer_size = static_cast<size_t>(streaming_data.nb_chunk_rows + 1) * row_size * nb_vertex_floats(in_rendering_config) * sizeof(GLfloat);
+        const size_t index_buffer_size = static_cast<size_t>(streaming_data.nb_chunk_rows) * nb_strip_indices * sizeof(GLuint);
+        streaming_data.vertex_buffer_size = vertex_buffer_size;
+        streaming_data.index_buffer_size = index_buffer_size;
+
+        streaming_data.vertex_buffer_ids.resize(STREAMING_RING_SIZE, 0);
+        streaming_data.index_buffer_ids.resize(STREAMING_RING_SIZE, 0);
+        streaming_data.fences.resize(STREAMING_RING_SIZE, 0);
+        glGenBuffers(STREAMING_RING_SIZE, &streaming_data.vertex_buffer_ids[0]);
+        glGenBuffers(STREAMING_RING_SIZE, &streaming_data.index_buffer_ids[0]);
+        for (unsigned int i = 0; i < STREAMING_RING_SIZE; ++i)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, streaming_data.vertex_buffer_ids[i]);
+            glBufferData(GL_ARRAY_BUFFER, vertex_buffer_size, NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streaming_data.index_buffer_ids[i]);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_size, NULL, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        streaming_data.ring_size = STREAMING_RING_SIZE * (vertex_buffer_size + index_buffer_size);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_streaming(RenderingData& io_rendering_data)
+{
+    StreamingData& streaming_data = io_rendering_data.streaming;
+    if (streaming_data.vertex_buffer_ids.empty())
+    {
+        return;
+    }
+
+    for (unsigned int i = 0; i < streaming_data.fences.size(); ++i)
+    {
+        if (streaming_data.fences[i])
+        {
+            glDeleteSync(streaming_data.fences[i]);
+        }
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glDeleteBuffers(streaming_data.vertex_buffer_ids.size(), &streaming_data.vertex_buffer_ids[0]);
+    glDeleteBuffers(streaming_data.index_buffer_ids.size(), &streaming_data.index_buffer_ids[0]);
+
+    streaming_data.vertex_buffer_ids.clear();
+    streaming_data.index_buffer_ids.clear();
+    streaming_data.fences.clear();
+    streaming_data.chunk_geometry = Geometry();
+    streaming_data.nb_subdivisions = 0;
+    streaming_data.nb_chunk_rows = 0;
+    streaming_data.vertex_buffer_size = 0;
+    streaming_data.index_buffer_size = 0;
+    streaming_data.ring_size = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void clear_streaming_stats(StreamingData& out_streaming_data)
+{
+    out_streaming_data.nb_frames = 0;
+    out_streaming_data.uploaded_size = 0;
+    out_streaming_data.generate_time = 0;
+    out_streaming_data.upload_time = 0;
+    out_streaming_data.wait_time = 0;
+    out_streaming_data.nb_orphaned_chunks = 0;
+    out_streaming_data.nb_failed_chunks = 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void stream_model(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    StreamingData& streaming_data = io_rendering_data.streaming;
+    if (streaming_data.vertex_buffer_ids.empty())
+    {
+        return;
+    }
+
+    if (!in_rendering_config.rendering_options.test(COLOR))
+    {
+        glColor3d(1.0, 1.0, 1.0);
+    }
+
+    const unsigned int nb_subdivisions = streaming_data.nb_subdivisions;
+    const unsigned int row_size = nb_subdivisions + 1;
+    const unsigned int vertex_data_size = nb_vertex_floats(in_rendering_config);
+    Geometry& chunk_geometry = streaming_data.chunk_geometry;
+
+    for (unsigned int first_row = 0; first_row < nb_subdivisions; first_row += streaming_data.nb_chunk_rows)
+    {
+        const unsigned int last_row = std::min(first_row + streaming_data.nb_chunk_rows, nb_subdivisions);
+        const unsigned int buffer_id = streaming_data.next_buffer;
+        streaming_data.next_buffer = (streaming_data.next_buffer + 1) % STREAMING_RING_SIZE;
+
+        // The GPU must be done with the chunk previously streamed into this buffer pair
+        bool orphan = (glFenceSync == NULL);
+        if (streaming_data.fences[buffer_id])
+        {
+            ScopedTimer timer(streaming_data.wait_time);
+            const GLenum wait_result = glClientWaitSync(streaming_data.fences[buffer_id], GL_SYNC_FLUSH_COMMANDS_BIT, STREAMING_FENCE_TIMEOUT);
+            orphan = (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED);
+            glDeleteSync(streaming_data.fences[buffer_id]);
+            streaming_data.fences[buffer_id] = 0;
+        }
+
+        // A row of margin on each side gives the chunk the normals of the whole model
+        const unsigned int band_first_row = first_row ? first_row - 1 : 0;
+        const unsigned int band_last_row = std::min(last_row + 1, nb_subdivisions);
+        {
+            ScopedTimer timer(streaming_data.generate_time);
+            generate_geometry_rows(nb_subdivisions, band_first_row, band_last_row, chunk_geometry);
+            compute_normals(chunk_geometry);
+        }
+
+        // Pack the rows of the chunk straight into the mapped buffers, write only
+        const unsigned int first_vertex = (first_row - band_first_row) * row_size;
+        const unsigned int nb_vertices = (last_row - first_row + 1) * row_size;
+        std::list<TriangleStrip>::iterator first_strip = chunk_geometry.triangles_strip.begin();
+        std::advance(first_strip, first_row - band_first_row);
+        unsigned int nb_indices = 0;
+        bool mapped = false;
+        {
+            ScopedTimer timer(streaming_data.upload_time);
+            glBindBuffer(GL_ARRAY_BUFFER, streaming_data.vertex_buffer_ids[buffer_id]);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, streaming_data.index_buffer_ids[buffer_id]);
+            if (orphan)
+            {
+                // Unknown whether the GPU still reads the buffer pair : new storage, the driver frees the old one once drawn
+                glBufferData(GL_ARRAY_BUFFER, streaming_data.vertex_buffer_size, NULL, GL_STREAM_DRAW);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, streaming_data.index_buffer_size, NULL, GL_STREAM_DRAW);
+                ++streaming_data.nb_orphaned_chunks;
+            }
+            GLfloat* p_vertex_buffer = static_cast<GLfloat*>(glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
+            GLuint* p_index_buffer = static_cast<GLuint*>(glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
+            mapped = (p_vertex_buffer && p_index_buffer);
+            if (mapped)
+            {
+                pack_vertex_buffer(chunk_geometry, in_rendering_config, first_vertex, nb_vertices, p_vertex_buffer);
+
+                std::list<TriangleStrip>::iterator it = first_strip;
+                for (unsigned int i = first_row; i < last_row; ++i, ++it)
+                {
+                    // Vertex ids relative to the first row of the chunk
+                    for (std::vector<unsigned int>::iterator id_it = it->vertex_ids.begin(); id_it != it->vertex_ids.end(); ++id_it)
+                    {
+                        *id_it -= first_vertex;
+                    }
+                    nb_indices += pack_strip_indices(*it, in_rendering_config, p_index_buffer + nb_indices);
+                }
+            }
+            // Only a mapped buffer can be unmapped
+            if (p_vertex_buffer)
+            {
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            }
+            if (p_index_buffer)
+            {
+                glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+            }
+        }
+        if (!mapped)
+        {
+            // Nothing written, nothing to count nor draw
+            ++streaming_data.nb_failed_chunks;
+            continue;
+        }
+        const size_t chunk_size = static_cast<size_t>(nb_vertices) * vertex_data_size * sizeof(GLfloat) + static_cast<size_t>(nb_indices) * sizeof(GLuint);
+        streaming_data.uploaded_size += chunk_size;
+        GL_COUNT_BYTES(chunk_size);     // written through the mapped buffers
+
+        // Draw the chunk, the GPU draws it while the next chunk is generated
+        enable_vbo_client_state(in_rendering_config);
+        if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
+        {
+            size_t offset = 0;
+            std::list<TriangleStrip>::const_iterator it = first_strip;
+            for (unsigned int i = first_row; i < last_row && offset < nb_indices * sizeof(GLuint); ++i, ++it)
+            {
+                const unsigned int vertex_ids_size = it->vertex_ids.size();
+                glDrawElements(GL_TRIANGLE_STRIP, vertex_ids_size, GL_UNSIGNED_INT, BUFFER_OFFSET_CAST(offset));
+                offset += vertex_ids_size * sizeof(GLuint);
+            }
+        }
+        else
+        {
+            glDrawElements(GL_TRIANGLES, nb_indices, GL_UNSIGNED_INT, BUFFER_OFFSET_CAST(0));
+        }
+        if (glFenceSync)
+        {
+            streaming_data.fences[buffer_id] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        glFlush();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_streaming_stats(std::ostream& out_stream, const StreamingData& in_streaming_data, const std::deque<long>& in_rendering_times)
+{
+    if (in_streaming_data.vertex_buffer_ids.empty() || !in_streaming_data.nb_frames)
+    {
+        return;
+    }
+    const double mean_rendering_time = mean_time(in_rendering_times);   // us
+    const double mega_byte = 1024.0 * 1024.0;
+    const double nb_frames = in_streaming_data.nb_frames;
+    const double frame_uploaded_size = in_streaming_data.uploaded_size / nb_frames;
+
+    out_stream << "| streaming : " << (in_streaming_data.nb_subdivisions + in_streaming_data.nb_chunk_rows - 1) / in_streaming_data.nb_chunk_rows
+               << " chunks of " << 2 * in_streaming_data.nb_chunk_rows * in_streaming_data.nb_subdivisions << " triangles, ";
+    print_fixed(out_stream, frame_uploaded_size / mega_byte, 1);
+    out_stream << " MB per frame";
+    if (mean_rendering_time > 0.0)
+    {
+        out_stream << " (";
+        print_fixed(out_stream, frame_uploaded_size / mega_byte / (mean_rendering_time / 1000000.0), 1);
+        out_stream << " MB/s)";
+    }
+    out_stream << ", generation ";
+    print_fixed(out_stream, in_streaming_data.generate_time / nb_frames / 1000.0, 2);
+    out_stream << " ms, pack and upload ";
+    print_fixed(out_stream, in_streaming_data.upload_time / nb_frames / 1000.0, 2);
+    out_stream << " ms, fence wait ";
+    print_fixed(out_stream, in_streaming_data.wait_time / nb_frames / 1000.0, 2);
+    out_stream << " ms";
+    if (in_streaming_data.nb_orphaned_chunks)
+    {
+        out_stream << ", orphaned chunks " << in_streaming_data.nb_orphaned_chunks;
+    }
+    if (in_streaming_data.nb_failed_chunks)
+    {
+        out_stream << ", failed chunks (not mapped) " << in_streaming_data.nb_failed_chunks;
+    }
+    out_stream << "      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+GLuint compile_shader(GLenum in_shader_type, const char* in_source)
+{
+    GLuint shader_id = glCreateShader(in_shader_type);
+    glShaderSource(shader_id, 1, &in_source, NULL);
+    glCompileShader(shader_id);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE)
+    {
+        GLchar info_log[1024];
+        glGetShaderInfoLog(shader_id, sizeof(info_log), NULL, info_log);
+        std::cout << "Warning : shader compilation failed : " << info_log << std::endl;
+        glDeleteShader(shader_id);
+        return 0;
+    }
+    return shader_id;
+}
+
+////////////////////////////////////////////////////////////////////////
+GLuint link_program(GLuint in_shader_id)
+{
+    GLuint program_id = glCreateProgram();
+    glAttachShader(program_id, in_shader_id);
+    glLinkProgram(program_id);
+    glDeleteShader(in_shader_id);   // deleted with the program
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE)
+    {
+        GLchar info_log[1024];
+        glGetProgramInfoLog(program_id, sizeof(info_log), NULL, info_log);
+        std::cout << "Warning : program link failed : " << info_log << std::endl;
+        glDeleteProgram(program_id);
+        return 0;
+    }
+    return program_id;
+}
 
-    while (event_type != QUIT_REQUESTED
-           &&
-           SDL_PollEvent(&event))           // poll event by event
+////////////////////////////////////////////////////////////////////////
+void process_procedural(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    io_rendering_data.setup_times.shader_build = 0;
+
+    delete_procedural(io_rendering_data);
+
+    if (in_rendering_config.rendering_method != PROCEDURAL || !glCreateShader)
     {
-        switch (event.type)
+        return;
+    }
+
+    ScopedTimer timer(io_rendering_data.setup_times.shader_build);
+    ProceduralData& procedural_data = io_rendering_data.procedural;
+
+    // Fixed function fragments : texturing and flat shading follow the config as for the other methods
+    const GLuint shader_id = compile_shader(GL_VERTEX_SHADER, PROCEDURAL_VERTEX_SHADER);
+    if (!shader_id)
+    {
+        return;
+    }
+    procedural_data.program_id = link_program(shader_id);
+    if (!procedural_data.program_id)
+    {
+        return;
+    }
+
+    const unsigned int nb_subdivisions = nb_grid_subdivisions(io_rendering_data.model_nb_triangles);
+    const bool triangle_strip = in_rendering_config.rendering_options.test(TRIANGLE_STRIP);
+    glUseProgram(procedural_data.program_id);
+    glUniform1i(glGetUniformLocation(procedural_data.program_id, "nb_subdivisions"), nb_subdivisions);
+    glUniform1i(glGetUniformLocation(procedural_data.program_id, "triangle_strip"), triangle_strip);
+    glUniform1i(glGetUniformLocation(procedural_data.program_id, "vertex_color"), in_rendering_config.rendering_options.test(COLOR));
+    glUniform1i(glGetUniformLocation(procedural_data.program_id, "nb_lights"), in_rendering_config.nb_lights);
+    glUniform1i(glGetUniformLocation(procedural_data.program_id, "local_viewer"), in_rendering_config.rendering_options.test(LOCAL_VIEWER));
+    glUseProgram(0);
+
+    // Vertex ids are numbered strip after strip, the triangles are a single range
+    const unsigned int nb_strip_vertices = triangle_strip ? 2 * (nb_subdivisions + 1) : 6 * nb_subdivisions;
+    const unsigned int nb_ranges = triangle_strip ? nb_subdivisions : 1;
+    procedural_data.strip_firsts.resize(nb_ranges);
+    procedural_data.strip_counts.resize(nb_ranges);
+    for (unsigned int i = 0; i < nb_ranges; ++i)
+    {
+        procedural_data.strip_firsts[i] = i * nb_strip_vertices;
+        procedural_data.strip_counts[i] = triangle_strip ? nb_strip_vertices : nb_subdivisions * nb_strip_vertices;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_procedural(RenderingData& io_rendering_data)
+{
+    ProceduralData& procedural_data = io_rendering_data.procedural;
+    if (procedural_data.program_id)
+    {
+        glDeleteProgram(procedural_data.program_id);
+        procedural_data.program_id = 0;
+    }
+    procedural_data.strip_firsts.clear();
+    procedural_data.strip_counts.clear();
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_culling(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    delete_culling(io_rendering_data);
+
+    if (in_rendering_config.rendering_method != GPU_CULLED || !glDispatchCompute)
+    {
+        return;
+    }
+
+    CullingData& culling_data = io_rendering_data.culling;
+    {
+        ScopedTimer timer(io_rendering_data.setup_times.shader_build);
+        const GLuint shader_id = compile_shader(GL_COMPUTE_SHADER, CULLING_COMPUTE_SHADER);
+        if (!shader_id)
         {
-            ///////////////////////////////////
-            case SDL_KEYDOWN:
-                switch (event.key.keysym.sym)
-                {
-                    case SDLK_q:
-                    case SDLK_ESCAPE:
-                        event_type = QUIT_REQUESTED;
-                        break;
+            return;
+        }
+        culling_data.program_id = link_program(shader_id);
+        if (!culling_data.program_id)
+        {
+            return;
+        }
+        culling_data.frustum_planes_location = glGetUniformLocation(culling_data.program_id, "frustum_planes");
+        culling_data.eye_position_location = glGetUniformLocation(culling_data.program_id, "eye_position");
+        culling_data.cone_culling_location = glGetUniformLocation(culling_data.program_id, "cone_culling");
+    }
 
-                    case SDLK_EQUALS:
-                    case SDLK_PLUS:
-                    case SDLK_KP_PLUS:
-                        io_rendering_config.nb_triangles *= 2;
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
+    // Clusters follow the strips of the index buffer
+    std::vector<ClusterBounds> clusters(count_clusters(model_geometry(io_rendering_data)));
+    {
+        ScopedTimer timer(io_rendering_data.setup_times.vbo_packing);
+        pack_clusters(model_geometry(io_rendering_data), in_rendering_config, &clusters[0]);
+    }
+    culling_data.nb_clusters = clusters.size();
+
+    ScopedTimer timer(io_rendering_data.setup_times.vbo_upload);
+    const GLuint counters[2] = {0, 0};
+    const size_t command_buffer_size = culling_data.nb_clusters * 5 * sizeof(GLuint);
+    glGenBuffers(1, &culling_data.cluster_buffer_id);
+    glGenBuffers(1, &culling_data.command_buffer_id);
+    glGenBuffers(1, &culling_data.counter_buffer_id);
+    glGenBuffers(1, &culling_data.counter_copy_buffer_id);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling_data.cluster_buffer_id);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, clusters.size() * sizeof(ClusterBounds), &clusters[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling_data.command_buffer_id);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, command_buffer_size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culling_data.counter_buffer_id);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counters), counters, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, culling_data.counter_copy_buffer_id);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(counters), NULL, GL_STREAM_READ);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    culling_data.buffers_size = clusters.size() * sizeof(ClusterBounds) + command_buffer_size + 2 * sizeof(counters);
+
+    glUseProgram(culling_data.program_id);
+    glUniform1i(glGetUniformLocation(culling_data.program_id, "nb_clusters"), culling_data.nb_clusters);
+    glUseProgram(0);
+}
 
-                    case SDLK_MINUS:
-                    case SDLK_KP_MINUS:
-                        if (io_rendering_config.nb_triangles > 2500)
-                        {
-                            io_rendering_config.nb_triangles /= 2;
-                        }
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_w:
-                        io_rendering_config.rendering_options.flip(WIREFRAME);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_m:
-                        io_rendering_config.rendering_options.flip(SMOOTH_SHADING);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_c:
-                        io_rendering_config.rendering_options.flip(COLOR);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_t:
-                        io_rendering_config.rendering_options.flip(TEXTURE);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_p:
-                        io_rendering_config.rendering_options.flip(BACK_FACE_PAINTING);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_s:
-                        io_rendering_config.rendering_options.flip(TRIANGLE_STRIP);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_F1:
-                    case SDLK_F2:
-                    case SDLK_F3:
-                    case SDLK_F4:
-                        io_rendering_config.rendering_method = static_cast<RenderingMethod>(event.key.keysym.sym - SDLK_F1 + 1);
-                        event_type = RENDERING_CONFIG_CHANGED;
-                        break;
-                    case SDLK_SPACE:
-                        io_display_config.rotation = !io_display_config.rotation;
-                        break;
-                    case SDLK_b:
-                        event_type = BENCH_REQUESTED;
+////////////////////////////////////////////////////////////////////////
+void delete_culling(RenderingData& io_rendering_data)
+{
+    CullingData& culling_data = io_rendering_data.culling;
+    if (culling_data.counter_fence)
+    {
+        glDeleteSync(culling_data.counter_fence);
+        culling_data.counter_fence = 0;
+    }
+    if (culling_data.program_id)
+    {
+        glDeleteProgram(culling_data.program_id);
+        culling_data.program_id = 0;
+    }
+    if (culling_data.cluster_buffer_id)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDeleteBuffers(1, &culling_data.cluster_buffer_id);
+        glDeleteBuffers(1, &culling_data.command_buffer_id);
+        glDeleteBuffers(1, &culling_data.counter_buffer_id);
+        glDeleteBuffers(1, &culling_data.counter_copy_buffer_id);
+        culling_data.cluster_buffer_id = 0;
+        culling_data.command_buffer_id = 0;
+        culling_data.counter_buffer_id = 0;
+        culling_data.counter_copy_buffer_id = 0;
+    }
+    culling_data.nb_clusters = 0;
+    culling_data.buffers_size = 0;
+    clear_culling_stats(culling_data);
+}
 
-                    default:
-                        break;
-                }
-                break;
+////////////////////////////////////////////////////////////////////////
+void clear_culling_stats(CullingData& io_culling_data)
+{
+    if (io_culling_data.counter_fence)
+    {
+        glDeleteSync(io_culling_data.counter_fence);
+        io_culling_data.counter_fence = 0;
+    }
+    if (io_culling_data.counter_buffer_id)
+    {
+        const GLuint counters[2] = {0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, io_culling_data.counter_buffer_id);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), counters);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    io_culling_data.nb_dispatches = 0;
+    io_culling_data.nb_fenced_dispatches = 0;
+    io_culling_data.nb_read_dispatches = 0;
+    io_culling_data.nb_frustum_culled = 0;
+    io_culling_data.nb_cone_culled = 0;
+}
 
-            ///////////////////////////////////
-            case SDL_MOUSEBUTTONDOWN:
-                if (event.button.button == SDL_BUTTON_LEFT)
-                {
-                    mouse_left_button_down = true;
-                    mouse_current_position_x = -1;
-                    mouse_current_position_y = -1;
-                }
-                else if (event.button.button == SDL_BUTTON_WHEELDOWN)
-                {
-                    io_display_config.move_forward -= 0.1;
-                }
-                else if (event.button.button == SDL_BUTTON_WHEELUP)
-                {
-                    io_display_config.move_forward += 0.1;
-                }
-                break;
+////////////////////////////////////////////////////////////////////////
+void compute_culling_view(GLfloat* out_frustum_planes, GLfloat* out_eye_position)
+{
+    GLfloat modelview[16];
+    GLfloat projection[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+    // Clip planes in object space from the rows of projection * modelview (column major) : left, right, bottom, top, near, far
+    GLfloat matrix[16];
+    for (unsigned int column = 0; column < 4; ++column)
+    {
+        for (unsigned int row = 0; row < 4; ++row)
+        {
+            matrix[column * 4 + row] = 0.0f;
+            for (unsigned int k = 0; k < 4; ++k)
+            {
+                matrix[column * 4 + row] += projection[k * 4 + row] * modelview[column * 4 + k];
+            }
+        }
+    }
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        const GLfloat sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        GLfloat* plane = out_frustum_planes + 4 * i;
+        for (unsigned int column = 0; column < 4; ++column)
+        {
+            plane[column] = matrix[column * 4 + 3] + sign * matrix[column * 4 + i / 2];
+        }
+        const GLfloat length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        for (unsigned int column = 0; column < 4; ++column)
+        {
+            plane[column] /= length;
+        }
+    }
 
-            ///////////////////////////////////
-            case SDL_MOUSEBUTTONUP:
-                if (event.button.button == SDL_BUTTON_LEFT)
-                {
-                    mouse_left_button_down = false;
-                }
-                break;
+    // Eye in object space : the modelview is a rotation, a uniform scale and a translation, its inverse is its transpose over the squared scale
+    const GLfloat squared_scale = modelview[0] * modelview[0] + modelview[1] * modelview[1] + modelview[2] * modelview[2];
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        out_eye_position[i] = -(modelview[i * 4] * modelview[12] + modelview[i * 4 + 1] * modelview[13] + modelview[i * 4 + 2] * modelview[14]) / squared_scale;
+    }
+}
 
-            ///////////////////////////////////
-            case SDL_MOUSEMOTION:
-                if (mouse_left_button_down)
-                {
-                    if (mouse_current_position_x == -1 || mouse_current_position_y == -1)
-                    {
-                        mouse_current_position_x = event.button.x;
-                        mouse_current_position_y = event.button.y;
-                    }
-                    else
-                    {
-                        io_display_config.rotation_angle_x += event.button.y - mouse_current_position_y;
-                        io_display_config.rotation_angle_y += event.button.x - mouse_current_position_x;
-                        mouse_current_position_x = event.button.x;
-                        mouse_current_position_y = event.button.y;
-                    }
-                }
-                break;
+////////////////////////////////////////////////////////////////////////
+void cull_clusters(CullingData& io_culling_data)
+{
+    // Copy of the counters of a previous frame, once the GPU is done with it : no later command writes the copy, the read does not stall
+    if (io_culling_data.counter_fence)
+    {
+        const GLenum wait_result = glClientWaitSync(io_culling_data.counter_fence, 0, 0);
+        if (wait_result == GL_ALREADY_SIGNALED || wait_result == GL_CONDITION_SATISFIED)
+        {
+            GLuint counters[2];
+            glBindBuffer(GL_COPY_READ_BUFFER, io_culling_data.counter_copy_buffer_id);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(counters), counters);
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            io_culling_data.nb_frustum_culled = counters[0];
+            io_culling_data.nb_cone_culled = counters[1];
+            io_culling_data.nb_read_dispatches = io_culling_data.nb_fenced_dispatches;
+            glDeleteSync(io_culling_data.counter_fence);
+            io_culling_data.counter_fence = 0;
+        }
+    }
 
-            ///////////////////////////////////
-            case SDL_QUIT:                  // Quit resquested : "close button" of the window
-                event_type = QUIT_REQUESTED;
-                break;
+    GLfloat frustum_planes[6 * 4];
+    GLfloat eye_position[3];
+    compute_culling_view(frustum_planes, eye_position);
+
+    // Back faces are only rejected when the current object culls them
+    glUseProgram(io_culling_data.program_id);
+    glUniform4fv(io_culling_data.frustum_planes_location, 6, frustum_planes);
+    glUniform3fv(io_culling_data.eye_position_location, 1, eye_position);
+    glUniform1i(io_culling_data.cone_culling_location, glIsEnabled(GL_CULL_FACE));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, io_culling_data.cluster_buffer_id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, io_culling_data.command_buffer_id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, io_culling_data.counter_buffer_id);
+    glDispatchCompute((io_culling_data.nb_clusters + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+    ++io_culling_data.nb_dispatches;
+
+    // The copy holds the counters of exactly the dispatches submitted so far
+    if (!io_culling_data.counter_fence)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, io_culling_data.counter_buffer_id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, io_culling_data.counter_copy_buffer_id);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, 2 * sizeof(GLuint));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        io_culling_data.counter_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        io_culling_data.nb_fenced_dispatches = io_culling_data.nb_dispatches;
+    }
+}
 
-            ///////////////////////////////////
-            default:
-                break;
+////////////////////////////////////////////////////////////////////////
+void print_culling_stats(std::ostream& out_stream, const CullingData& in_culling_data)
+{
+    if (!in_culling_data.program_id || !in_culling_data.nb_read_dispatches)
+    {
+        return;
+    }
+    const double nb_tested_clusters = static_cast<double>(in_culling_data.nb_read_dispatches) * in_culling_data.nb_clusters;
+    const double nb_culled_clusters = static_cast<double>(in_culling_data.nb_frustum_culled + in_culling_data.nb_cone_culled);
+
+    out_stream << "| GPU culling : " << in_culling_data.nb_clusters << " clusters of " << CLUSTER_NB_TRIANGLES << " triangles, ";
+    print_fixed(out_stream, nb_culled_clusters / in_culling_data.nb_read_dispatches, 0);
+    out_stream << " culled per draw (";
+    print_fixed(out_stream, 100.0 * nb_culled_clusters / nb_tested_clusters, 1);
+    out_stream << " %, frustum ";
+    print_fixed(out_stream, 100.0 * in_culling_data.nb_frustum_culled / nb_tested_clusters, 1);
+    out_stream << " %, back-facing ";
+    print_fixed(out_stream, 100.0 * in_culling_data.nb_cone_culled / nb_tested_clusters, 1);
+    out_stream << " %)      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_framebuffer(RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config)
+{
+    delete_framebuffer(io_rendering_data);
+
+    io_rendering_data.rendering_width  = in_display_config.windows_width;
+    io_rendering_data.rendering_height = in_display_config.windows_height;
+
+    if (in_rendering_config.framebuffer_width && in_rendering_config.framebuffer_height && glGenFramebuffers)
+    {
+        const unsigned int width  = in_rendering_config.framebuffer_width;
+        const unsigned int height = in_rendering_config.framebuffer_height;
+
+        glGenRenderbuffers(1, &io_rendering_data.color_renderbuffer_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, io_rendering_data.color_renderbuffer_id);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+        glGenRenderbuffers(1, &io_rendering_data.depth_renderbuffer_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, io_rendering_data.depth_renderbuffer_id);
+        glRenderbufferStorage(GL_RENDERBUFFER, depth_internal_format(in_rendering_config.depth_format), width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        // The framebuffer stays bound : every frame is rendered in it, the window is not updated
+        glGenFramebuffers(1, &io_rendering_data.framebuffer_id);
+        glBindFramebuffer(GL_FRAMEBUFFER, io_rendering_data.framebuffer_id);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, io_rendering_data.color_renderbuffer_id);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, io_rendering_data.depth_renderbuffer_id);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Warning : " << width << "x" << height << " framebuffer is not supported, rendering in the window" << std::endl;
+            delete_framebuffer(io_rendering_data);
+        }
+        else
+        {
+            io_rendering_data.rendering_width  = width;
+            io_rendering_data.rendering_height = height;
+            process_multisample(io_rendering_data, in_rendering_config);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+void delete_framebuffer(RenderingData& io_rendering_data)
+{
+    if (io_rendering_data.framebuffer_id)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        delete_multisample(io_rendering_data.multisample);
+        glDeleteFramebuffers(1, &io_rendering_data.framebuffer_id);
+        io_rendering_data.framebuffer_id = 0;
+    }
+    if (io_rendering_data.color_renderbuffer_id)
+    {
+        glDeleteRenderbuffers(1, &io_rendering_data.color_renderbuffer_id);
+        io_rendering_data.color_renderbuffer_id = 0;
+    }
+    if (io_rendering_data.depth_renderbuffer_id)
+    {
+        glDeleteRenderbuffers(1, &io_rendering_data.depth_renderbuffer_id);
+        io_rendering_data.depth_renderbuffer_id = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+GLenum depth_internal_format(DepthFormat in_depth_format)
+{
+    if (in_depth_format == DEPTH_16)
+        return GL_DEPTH_COMPONENT16;
+    else if (in_depth_format == DEPTH_32F)
+        return GL_DEPTH_COMPONENT32F;
+    return GL_DEPTH_COMPONENT24;
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_multisample(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    MultisampleData& multisample_data = io_rendering_data.multisample;
+    clear_multisample_stats(multisample_data);
+
+    // Fall back to the highest supported count, down to the single sampled framebuffer
+    unsigned int nb_samples = in_rendering_config.nb_samples;
+    if (nb_samples > 1)
+    {
+        GLint max_samples = 1;
+        if (glRenderbufferStorageMultisample && glBlitFramebuffer)
+        {
+            glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+        }
+        while (nb_samples > 1 && nb_samples > static_cast<unsigned int>(max_samples))
+        {
+            nb_samples /= 2;
+        }
+        if (nb_samples != in_rendering_config.nb_samples)
+        {
+            std::cout << "Warning : " << in_rendering_config.nb_samples << " samples are not supported, rendering with " << nb_samples << std::endl;
         }
     }
-
-    return event_type;
+
+    if (nb_samples > 1)
+    {
+        const unsigned int width  = io_rendering_data.rendering_width;
+        const unsigned int height = io_rendering_data.rendering_height;
+
+        glGenRenderbuffers(1, &multisample_data.color_renderbuffer_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, multisample_data.color_renderbuffer_id);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, nb_samples, GL_RGBA8, width, height);
+
+        glGenRenderbuffers(1, &multisample_data.depth_renderbuffer_id);
+        glBindRenderbuffer(GL_RENDERBUFFER, multisample_data.depth_renderbuffer_id);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, nb_samples, depth_internal_format(in_rendering_config.depth_format), width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &multisample_data.framebuffer_id);
+        glBindFramebuffer(GL_FRAMEBUFFER, multisample_data.framebuffer_id);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, multisample_data.color_renderbuffer_id);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, multisample_data.depth_renderbuffer_id);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "Warning : " << nb_samples << " samples framebuffer is not supported, rendering single sampled" << std::endl;
+            delete_multisample(multisample_data);
+        }
+        else
+        {
+            multisample_data.nb_samples = nb_samples;
+        }
+
+        // The single sampled framebuffer stays bound between frames, it holds the resolved frame
+        glBindFramebuffer(GL_FRAMEBUFFER, io_rendering_data.framebuffer_id);
+    }
+
+    if (glQueryCounter && multisample_data.query_ids.empty())
+    {
+        multisample_data.query_ids.resize(3 * MULTISAMPLE_QUERY_RING_SIZE);
+        glGenQueries(multisample_data.query_ids.size(), &multisample_data.query_ids[0]);
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////
-void print_config(const RenderingConfig& in_rendering_config, std::ostream& out_stream)
-{
-    out_stream << std::endl << "X--------------------------------------------------X" << std::endl;
-    out_stream << " - ('F1/2/3/4') Rendering method .. ";
-    if (in_rendering_config.rendering_method == IMMEDIATE)
-        out_stream << "Immediate" << std::endl;
-    else if (in_rendering_config.rendering_method == CALL_LIST)
-        out_stream << "Call list" << std::endl;
-    else if (in_rendering_config.rendering_method == STATIC_VBO)
-        out_stream << "Static VBO" << std::endl;
-    else if (in_rendering_config.rendering_method == DYNAMIC_VBO)
-        out_stream << "Dynamic VBO" << std::endl;
-    else
-        out_stream << "Not yet implemented" << std::endl;
-    out_stream << " - ('s') Triangles strip mode ..... " << in_rendering_config.rendering_options.test(TRIANGLE_STRIP) << std::endl;
-    out_stream << " - ('c') Colored model ............ " << in_rendering_config.rendering_options.test(COLOR) << std::endl;
-    out_stream << " - ('t') Textured model ........... " << in_rendering_config.rendering_options.test(TEXTURE) << std::endl;
-    out_stream << " - ('m') Smooth shading ........... " << in_rendering_config.rendering_options.test(SMOOTH_SHADING) << std::endl;
-    out_stream << " - ('p') Back face painting ....... " << in_rendering_config.rendering_options.test(BACK_FACE_PAINTING) << std::endl;
-    out_stream << " - ('w') Wireframe model .......... " << in_rendering_config.rendering_options.test(WIREFRAME) << std::endl;
-}
-
-//////////////////////////////////////////////////////////////////////////////
-void print_rendering_time (std::ostream& out_stream, unsigned int in_nb_triangles, const std::deque<long>& in_rendering_times)
+void delete_multisample(MultisampleData& io_multisample_data)
 {
-    double mean_rendering_time = 0.0;
-    for (std::deque<long>::const_iterator it = in_rendering_times.begin(); it != in_rendering_times.end(); ++it)
+    if (io_multisample_data.framebuffer_id)
     {
-        mean_rendering_time += static_cast<double>(*it);
+        glDeleteFramebuffers(1, &io_multisample_data.framebuffer_id);
+        io_multisample_data.framebuffer_id = 0;
     }
-    mean_rendering_time = mean_rendering_time / static_cast<double>(in_rendering_times.size());
-
-    out_stream << in_nb_triangles << " triangles rendered in " << static_cast<unsigned int>(mean_rendering_time + 0.5) << " ms";
-    if (in_rendering_times.size() < NB_MIN_FRAME)
+    if (io_multisample_data.color_renderbuffer_id)
     {
-        out_stream << '*';
+        glDeleteRenderbuffers(1, &io_multisample_data.color_renderbuffer_id);
+        io_multisample_data.color_renderbuffer_id = 0;
     }
-    out_stream << "      " << std::flush;
+    if (io_multisample_data.depth_renderbuffer_id)
+    {
+        glDeleteRenderbuffers(1, &io_multisample_data.depth_renderbuffer_id);
+        io_multisample_data.depth_renderbuffer_id = 0;
+    }
+    if (!io_multisample_data.query_ids.empty())
+    {
+        glDeleteQueries(io_multisample_data.query_ids.size(), &io_multisample_data.query_ids[0]);
+        io_multisample_data.query_ids.clear();
+    }
+    io_multisample_data.nb_samples = 1;
+    io_multisample_data.first_pending_query = 0;
+    io_multisample_data.nb_pending_queries = 0;
+    io_multisample_data.frame_open = false;
 }
 
 ////////////////////////////////////////////////////////////////////////
-Vector3d compute_normal(const Vector3d& in_v1, const Vector3d& in_v2, const Vector3d& in_v3)
+void clear_multisample_stats(MultisampleData& io_multisample_data)
 {
-    Vector3d vector1 = in_v2 - in_v1;
-    Vector3d vector2 = in_v3 - in_v1;
-    Vector3d normal(vector1.y * vector2.z - vector1.z * vector2.y,    // cross product
-                    vector1.z * vector2.x - vector1.x * vector2.z,
-                    vector1.x * vector2.y - vector1.y * vector2.x);
-    return normal / sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+    io_multisample_data.draw_times.clear();
+    io_multisample_data.resolve_times.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////
-void fill_normal(std::vector<Vertex>& out_vertices, unsigned int in_id1, unsigned int in_id2, unsigned int in_id3)
+void begin_multisample_frame(MultisampleData& io_multisample_data)
 {
-    Vector3d normal = compute_normal(out_vertices.at(in_id1).coord,
-                                     out_vertices.at(in_id2).coord,
-                                     out_vertices.at(in_id3).coord);
-    out_vertices.at(in_id1).normal = out_vertices.at(in_id1).normal + normal;
-    out_vertices.at(in_id2).normal = out_vertices.at(in_id2).normal + normal;
-    out_vertices.at(in_id3).normal = out_vertices.at(in_id3).normal + normal;
+    if (io_multisample_data.framebuffer_id)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, io_multisample_data.framebuffer_id);
+    }
+
+    // No query this frame when every frame of the ring is still in flight, the measure must not stall the pipeline
+    if (io_multisample_data.query_ids.empty() || io_multisample_data.nb_pending_queries == MULTISAMPLE_QUERY_RING_SIZE)
+    {
+        return;
+    }
+    const unsigned int slot = (io_multisample_data.first_pending_query + io_multisample_data.nb_pending_queries) % MULTISAMPLE_QUERY_RING_SIZE;
+    glQueryCounter(io_multisample_data.query_ids[3 * slot], GL_TIMESTAMP);
+    io_multisample_data.frame_open = true;
 }
 
 ////////////////////////////////////////////////////////////////////////
-void generate_model(const RenderingConfig& in_rendering_config, RenderingData& out_rendering_data)
+void resolve_multisample_frame(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
 {
-    out_rendering_data.geometry.vertices.clear();
-    out_rendering_data.geometry.triangles_strip.clear();
-
-    const unsigned int nb_subdivisions = static_cast<int>(sqrt(static_cast<double>(in_rendering_config.nb_triangles) / 2.0) + 0.5);
-
-    const double texture_coef = 10.0;
+    MultisampleData& multisample_data = io_rendering_data.multisample;
+    const unsigned int slot = (multisample_data.first_pending_query + multisample_data.nb_pending_queries) % MULTISAMPLE_QUERY_RING_SIZE;
+    if (multisample_data.frame_open)
+    {
+        glQueryCounter(multisample_data.query_ids[3 * slot + 1], GL_TIMESTAMP);
+    }
 
-    // Vertex generation
-    for (unsigned int i = 0; i <= nb_subdivisions; ++i)
+    if (multisample_data.framebuffer_id)
     {
-        double ratio_i = static_cast<double>(i) / static_cast<double>(nb_subdivisions);
+        // Depth is resolved only to be read back, it is not part of the frame otherwise
+        GLbitfield mask = GL_COLOR_BUFFER_BIT;
+        if (in_rendering_config.readback_mode != NO_READBACK && in_rendering_config.readback_format == READBACK_DEPTH)
+        {
+            mask |= GL_DEPTH_BUFFER_BIT;
+        }
+        const GLint width  = io_rendering_data.rendering_width;
+        const GLint height = io_rendering_data.rendering_height;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, multisample_data.framebuffer_id);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, io_rendering_data.framebuffer_id);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, mask, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, io_rendering_data.framebuffer_id);
+    }
 
-        const Vector3d color(1.0 - ratio_i, ratio_i, 1.0 - ratio_i);
+    if (multisample_data.frame_open)
+    {
+        glQueryCounter(multisample_data.query_ids[3 * slot + 2], GL_TIMESTAMP);
+        ++multisample_data.nb_pending_queries;
+        multisample_data.frame_open = false;
+    }
 
-        for (unsigned int j = 0; j <= nb_subdivisions; ++j)
+    // Collect the frames the GPU is done with
+    while (multisample_data.nb_pending_queries)
+    {
+        const unsigned int pending_slot = multisample_data.first_pending_query;
+        GLint available = 0;
+        glGetQueryObjectiv(multisample_data.query_ids[3 * pending_slot + 2], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
         {
-            double ratio_j = static_cast<double>(j) / static_cast<double>(nb_subdivisions);
+            break;
+        }
+        GLuint64 draw_begin = 0;
+        GLuint64 resolve_begin = 0;
+        GLuint64 resolve_end = 0;
+        glGetQueryObjectui64v(multisample_data.query_ids[3 * pending_slot], GL_QUERY_RESULT, &draw_begin);
+        glGetQueryObjectui64v(multisample_data.query_ids[3 * pending_slot + 1], GL_QUERY_RESULT, &resolve_begin);
+        glGetQueryObjectui64v(multisample_data.query_ids[3 * pending_slot + 2], GL_QUERY_RESULT, &resolve_end);
+
+        if (multisample_data.draw_times.size() >= NB_MIN_FRAME)
+        {
+            multisample_data.draw_times.pop_back();
+            multisample_data.resolve_times.pop_back();
+        }
+        multisample_data.draw_times.push_front(static_cast<long>(resolve_begin - draw_begin));
+        multisample_data.resolve_times.push_front(static_cast<long>(resolve_end - resolve_begin));
 
-            // Theta and phi
-            const double theta = -M_PI / 2.0 + M_PI * ratio_i;
-            const double phi = 2.0 * M_PI * ratio_j;
+        multisample_data.first_pending_query = (multisample_data.first_pending_query + 1) % MULTISAMPLE_QUERY_RING_SIZE;
+        --multisample_data.nb_pending_queries;
+    }
+}
 
-            // Construction of vertex
-            Vertex v;
+////////////////////////////////////////////////////////////////////////
+void print_multisample_times(std::ostream& out_stream, const MultisampleData& in_multisample_data)
+{
+    if (in_multisample_data.draw_times.empty())
+    {
+        return;
+    }
 
-            // Polar equation of a pseudo-donuts
-            v.coord  = Vector3d(cos(theta) * cos(phi), cos(theta) * sin(phi), sin(theta) * cos(theta));
-            v.color  = color;
-            v.normal = Vector3d(0.0, 0.0, 0.0);
-            v.texture_coordinate = Vector3d(texture_coef * ratio_i, texture_coef * ratio_j, 0.0);
+    // GPU side of the frame, the resolve is only there with several samples
+    const double nb_frames = static_cast<double>(in_multisample_data.draw_times.size());
+    double mean_draw_time = 0.0;
+    double mean_resolve_time = 0.0;
+    for (unsigned int i = 0; i < in_multisample_data.draw_times.size(); ++i)
+    {
+        mean_draw_time += in_multisample_data.draw_times[i] / 1000.0;
+        mean_resolve_time += in_multisample_data.resolve_times[i] / 1000.0;
+    }
 
-            out_rendering_data.geometry.vertices.push_back(v);
-        }
+    out_stream << "| GPU draw in ";
+    print_fixed(out_stream, mean_draw_time / nb_frames, 1);
+    out_stream << " us";
+    if (in_multisample_data.framebuffer_id)
+    {
+        out_stream << ", " << in_multisample_data.nb_samples << "x resolve in ";
+        print_fixed(out_stream, mean_resolve_time / nb_frames, 1);
+        out_stream << " us";
     }
+    out_stream << "      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+void process_readback(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    delete_readback(io_rendering_data);
 
-    // Triangle and Vertex's normal generation
-    // Compute the normal direction of each vertex with the sum of neighbor triangle's normal
-    for (unsigned int i = 0; i < nb_subdivisions; ++i)
+    ReadbackData& readback_data = io_rendering_data.readback;
+    readback_data.frame_id = 0;
+    readback_data.readback_times.clear();
+
+    if (in_rendering_config.readback_mode != NO_READBACK)
     {
-        TriangleStrip triangle_strip;
-        for (unsigned int j = 0; j <= nb_subdivisions; ++j)
+        readback_data.width  = io_rendering_data.rendering_width;
+        readback_data.height = io_rendering_data.rendering_height;
+        readback_data.frame_size = static_cast<size_t>(readback_data.width) * readback_data.height * 4;   // 4 bytes per pixel for every format
+
+        if (in_rendering_config.readback_mode == SYNC_READBACK)
         {
-            triangle_strip.vertex_ids.push_back(j + (i + 1) * (nb_subdivisions + 1));
-            triangle_strip.vertex_ids.push_back(j +  i      * (nb_subdivisions + 1));
+            readback_data.pixels.resize(readback_data.frame_size);
+        }
+        else if (in_rendering_config.readback_mode == PBO_READBACK)
+        {
+            readback_data.pixel_buffer_ids.resize(READBACK_RING_SIZE, 0);
+            readback_data.fences.resize(READBACK_RING_SIZE, 0);
 
-            if (j != nb_subdivisions)
+            glGenBuffers(READBACK_RING_SIZE, &readback_data.pixel_buffer_ids[0]);
+            for (unsigned int i = 0; i < READBACK_RING_SIZE; ++i)
             {
-                fill_normal(out_rendering_data.geometry.vertices,
-                            j + i * (nb_subdivisions + 1),
-                            (j + 1) + i * (nb_subdivisions + 1),
-                            j + (i + 1) * (nb_subdivisions + 1));
-                fill_normal(out_rendering_data.geometry.vertices,
-                            j + (i + 1) * (nb_subdivisions + 1),
-                            (j + 1) + i * (nb_subdivisions + 1),
-                            (j + 1) + (i + 1) * (nb_subdivisions + 1));
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_data.pixel_buffer_ids[i]);
+                glBufferData(GL_PIXEL_PACK_BUFFER, readback_data.frame_size, NULL, GL_STREAM_READ);
             }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
         }
 
-        Vector3d sum_normal_extremum = out_rendering_data.geometry.vertices.at(i * (nb_subdivisions + 1)).normal + out_rendering_data.geometry.vertices.at(nb_subdivisions + i * (nb_subdivisions + 1)).normal;
-        out_rendering_data.geometry.vertices.at(i * (nb_subdivisions + 1)).normal = sum_normal_extremum;
-        out_rendering_data.geometry.vertices.at(nb_subdivisions + i * (nb_subdivisions + 1)).normal = sum_normal_extremum;
-
-        out_rendering_data.geometry.triangles_strip.push_back(triangle_strip);
-    }
-
-    // Normalize the direction computed before, with the number of neighbor triangle
-    for (unsigned int i = 0; i <= nb_subdivisions; ++i)
-    {
-        for (unsigned int j = 0; j <= nb_subdivisions; ++j)
+        // Raw frames, one after the other : the file can be a named pipe to stream them to another process
+        if (in_rendering_config.rendering_options.test(CAPTURE))
         {
-            if (i == 0 || i == nb_subdivisions)
-            {
-                out_rendering_data.geometry.vertices.at(j + i * (nb_subdivisions + 1)).normal = out_rendering_data.geometry.vertices.at(j + i * (nb_subdivisions + 1)).normal / 3.0;
-            }
-            else
+            readback_data.capture_stream.open(CAPTURE_FILE, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!readback_data.capture_stream.is_open())
             {
-                out_rendering_data.geometry.vertices.at(j + i * (nb_subdivisions + 1)).normal = out_rendering_data.geometry.vertices.at(j + i * (nb_subdivisions + 1)).normal / 6.0;
+                std::cout << "Warning : unable to open " << CAPTURE_FILE << ", frames are not captured" << std::endl;
             }
         }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////
-void process_texturing(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+void delete_readback(RenderingData& io_rendering_data)
 {
-    delete_texturing(io_rendering_data);
+    ReadbackData& readback_data = io_rendering_data.readback;
 
-    if (in_rendering_config.rendering_options.test(TEXTURE))
+    for (unsigned int i = 0; i < readback_data.fences.size(); ++i)
     {
-        glGenTextures(1, &io_rendering_data.texture_id);
-        glBindTexture(GL_TEXTURE_2D, io_rendering_data.texture_id);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        GLubyte texture_data[16] = { 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0,
-                                     0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0 };
+        if (readback_data.fences[i])
+        {
+            glDeleteSync(readback_data.fences[i]);
+        }
+    }
+    readback_data.fences.clear();
 
-        gluBuild2DMipmaps(GL_TEXTURE_2D, 4, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, texture_data);
+    if (!readback_data.pixel_buffer_ids.empty())
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(readback_data.pixel_buffer_ids.size(), &readback_data.pixel_buffer_ids[0]);
+        readback_data.pixel_buffer_ids.clear();
     }
-}
 
-////////////////////////////////////////////////////////////////////////
-void delete_texturing(RenderingData& io_rendering_data)
-{
-    if (io_rendering_data.texture_id)
+    std::vector<unsigned char>().swap(readback_data.pixels);
+
+    if (readback_data.capture_stream.is_open())
     {
-        glDeleteTextures(1, &io_rendering_data.texture_id);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        io_rendering_data.texture_id = 0;
+        readback_data.capture_stream.close();
     }
+    readback_data.frame_size = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////
-void process_call_list(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+void readback_frame(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
 {
-    delete_call_list(io_rendering_data);
+    ReadbackData& readback_data = io_rendering_data.readback;
 
-    if (in_rendering_config.rendering_method == CALL_LIST)
+    if (in_rendering_config.readback_mode == NO_READBACK || readback_data.frame_size == 0)
     {
-        io_rendering_data.call_list_id = glGenLists(1);
-        glNewList(io_rendering_data.call_list_id, GL_COMPILE);
-        paint_gl(io_rendering_data.geometry, in_rendering_config);
-        glEndList();
+        return;
     }
-}
+    ScopedTrace trace("readback");
 
-////////////////////////////////////////////////////////////////////////
-void delete_call_list(RenderingData& io_rendering_data)
-{
-    if (io_rendering_data.call_list_id)
+    GLenum pixel_format = GL_RGBA;
+    GLenum pixel_type = GL_UNSIGNED_BYTE;
+    if (in_rendering_config.readback_format == READBACK_BGRA)
     {
-        glDeleteLists(io_rendering_data.call_list_id, 1);
-        io_rendering_data.call_list_id = 0;
+        pixel_format = GL_BGRA;
+    }
+    else if (in_rendering_config.readback_format == READBACK_DEPTH)
+    {
+        pixel_format = GL_DEPTH_COMPONENT;
+        pixel_type = GL_FLOAT;
     }
-}
 
-////////////////////////////////////////////////////////////////////////
-void process_vbo(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
-{
-    delete_vbo(io_rendering_data);
+    struct timeval start;
+    struct timeval end;
+    gettimeofday(&start, NULL);
 
-    if (in_rendering_config.rendering_method == STATIC_VBO || in_rendering_config.rendering_method == DYNAMIC_VBO)
+    if (in_rendering_config.readback_mode == SYNC_READBACK)
     {
-        const int gl_draw_method = (in_rendering_config.rendering_method == DYNAMIC_VBO) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
-
-        unsigned int vertex_data_size = 6;
-        if (in_rendering_config.rendering_options.test(COLOR))
-        {
-            vertex_data_size += 3;
-        }
-        if (in_rendering_config.rendering_options.test(TEXTURE))
-        {
-            vertex_data_size += 3;
-        }
+        glReadPixels(0, 0, readback_data.width, readback_data.height, pixel_format, pixel_type, &readback_data.pixels[0]);
+        consume_readback_frame(readback_data, in_rendering_config, &readback_data.pixels[0]);
+    }
+    else if (in_rendering_config.readback_mode == PBO_READBACK)
+    {
+        const unsigned int ring_size = readback_data.pixel_buffer_ids.size();
 
-        // VBO
-        GLfloat *p_vertex_buffer = new GLfloat[io_rendering_data.geometry.vertices.size() * vertex_data_size];
-        unsigned int offset = 0;
-        for (unsigned int i = 0; i < io_rendering_data.geometry.vertices.size(); ++i)
+        // Start the read of this frame, it completes asynchronously
+        const unsigned int write_id = readback_data.frame_id % ring_size;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_data.pixel_buffer_ids[write_id]);
+        glReadPixels(0, 0, readback_data.width, readback_data.height, pixel_format, pixel_type, BUFFER_OFFSET_CAST(0));
+        if (glFenceSync)
         {
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).coord.x);
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).coord.y);
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).coord.z);
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).normal.x);
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).normal.y);
-            p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).normal.z);
-            if (in_rendering_config.rendering_options.test(COLOR))
-            {
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).color.x);
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).color.y);
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).color.z);
-            }
-            if (in_rendering_config.rendering_options.test(TEXTURE))
-            {
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).texture_coordinate.x);
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).texture_coordinate.y);
-                p_vertex_buffer[offset++] = static_cast<GLfloat> (io_rendering_data.geometry.vertices.at(i).texture_coordinate.z);
-            }
+            readback_data.fences[write_id] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
         }
 
-        glGenBuffers(1, &io_rendering_data.vertex_buffer_id);
-        glBindBuffer(GL_ARRAY_BUFFER, io_rendering_data.vertex_buffer_id);
-        glBufferData(GL_ARRAY_BUFFER, io_rendering_data.geometry.vertices.size() * vertex_data_size * sizeof(GLfloat), p_vertex_buffer, gl_draw_method);
-
-        delete [] p_vertex_buffer;
-
-        // IBO
-        if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
+        // Consume the oldest read in flight, started ring_size - 1 frames ago
+        if (readback_data.frame_id + 1 >= ring_size)
         {
-            unsigned int nb_index = 0;
-            for (std::list<TriangleStrip>::const_iterator it = io_rendering_data.geometry.triangles_strip.begin(); it != io_rendering_data.geometry.triangles_strip.end(); ++it)
+            const unsigned int read_id = (readback_data.frame_id + 1) % ring_size;
+            if (readback_data.fences[read_id])
             {
-                nb_index += (*it).vertex_ids.size();
+                glClientWaitSync(readback_data.fences[read_id], GL_SYNC_FLUSH_COMMANDS_BIT, READBACK_FENCE_TIMEOUT);
+                glDeleteSync(readback_data.fences[read_id]);
+                readback_data.fences[read_id] = 0;
             }
-            GLuint *p_index_buffer = new GLuint[nb_index];
-
-            unsigned int offset = 0;
-            for (std::list<TriangleStrip>::const_iterator it = io_rendering_data.geometry.triangles_strip.begin(); it != io_rendering_data.geometry.triangles_strip.end(); ++it)
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_data.pixel_buffer_ids[read_id]);
+            const unsigned char* p_pixels = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+            if (p_pixels)
             {
-                for (unsigned int j = 0; j < (*it).vertex_ids.size(); ++j)
-                {
-                    p_index_buffer[offset] = static_cast<GLuint>((*it).vertex_ids.at(j));
-                    ++offset;
-                }
+                consume_readback_frame(readback_data, in_rendering_config, p_pixels);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
             }
-
-            glGenBuffers(1, &io_rendering_data.index_buffer_id);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, io_rendering_data.index_buffer_id);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, nb_index * sizeof(GLuint), p_index_buffer, gl_draw_method);
-
-            delete[] p_index_buffer;
         }
-        else
-        {
-            unsigned int nb_index = 0;
-            for (std::list<TriangleStrip>::const_iterator it = io_rendering_data.geometry.triangles_strip.begin(); it != io_rendering_data.geometry.triangles_strip.end(); ++it)
-            {
-                nb_index += ((*it).vertex_ids.size() - 2) * 3;
-            }
-            GLuint *p_index_buffer = new GLuint[nb_index];
-
-            unsigned int offset = 0;
-            for (std::list<TriangleStrip>::const_iterator it = io_rendering_data.geometry.triangles_strip.begin(); it != io_rendering_data.geometry.triangles_strip.end(); ++it)
-            {
-                for (unsigned int i = 0; i < (*it).vertex_ids.size() - 2; ++i)
-                {
-                    for (unsigned int j = 0; j < 3; ++j)
-                    {
-                        if (i % 2 == 0)
-                        {
-                            p_index_buffer[offset] = static_cast<GLuint>((*it).vertex_ids.at(i + j));
-                            ++offset;
-                        }
-                        else
-                        {
-                            p_index_buffer[offset] = static_cast<GLuint>((*it).vertex_ids.at(i + 2 - j));
-                            ++offset;
-                        }
-                    }
-                }
-            }
-
-            glGenBuffers(1, &io_rendering_data.index_buffer_id);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, io_rendering_data.index_buffer_id);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, nb_index * sizeof(GLuint), p_index_buffer, gl_draw_method);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    ++readback_data.frame_id;
 
-            delete[] p_index_buffer;
-        }
+    gettimeofday(&end, NULL);
 
-        // Enable client state
-        unsigned int buffer_offset = 0;
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glVertexPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
-        buffer_offset += 12;
-        glEnableClientState(GL_NORMAL_ARRAY);
-        glNormalPointer(GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
-        buffer_offset += 12;
-        if (in_rendering_config.rendering_options.test(COLOR))
-        {
-            glEnableClientState(GL_COLOR_ARRAY);
-            glColorPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
-            buffer_offset += 12;
-        }
-        if (in_rendering_config.rendering_options.test(TEXTURE))
-        {
-            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-            glTexCoordPointer(3, GL_FLOAT, vertex_data_size * sizeof(GLfloat), BUFFER_OFFSET_CAST(buffer_offset));
-            buffer_offset += 12;
-        }
+    if (readback_data.readback_times.size() >= NB_MIN_FRAME)
+    {
+        readback_data.readback_times.pop_back();
     }
+    readback_data.readback_times.push_front(elapsed_time_us(start, end));
 }
 
 ////////////////////////////////////////////////////////////////////////
-void delete_vbo(RenderingData& io_rendering_data)
+void consume_readback_frame(ReadbackData& io_readback_data, const RenderingConfig& in_rendering_config, const unsigned char* in_pixels)
 {
-    if (io_rendering_data.vertex_buffer_id || io_rendering_data.index_buffer_id)
+    if (in_rendering_config.rendering_options.test(CAPTURE) && io_readback_data.capture_stream.is_open())
     {
-        if (io_rendering_data.vertex_buffer_id) // vbo
-        {
-            // Disable client state
-            glDisableClientState(GL_VERTEX_ARRAY);
-            glDisableClientState(GL_COLOR_ARRAY);
-            glDisableClientState(GL_NORMAL_ARRAY);
-            glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-            // Unbind and delete buffer
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            glDeleteBuffers(1, &io_rendering_data.vertex_buffer_id);
-            io_rendering_data.vertex_buffer_id = 0;
-        }
-        if (io_rendering_data.index_buffer_id)  // ibo
-        {
-            // Unbind and delete buffer
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-            glDeleteBuffers(1, &io_rendering_data.index_buffer_id);
-            io_rendering_data.index_buffer_id = 0;
-        }
+        io_readback_data.capture_stream.write(reinterpret_cast<const char*>(in_pixels), io_readback_data.frame_size);
     }
 }
 
@@ -917,12 +4604,54 @@ void paint_gl(const RenderingConfig& in_rendering_config, const Vertex& in_verte
 }
 
 ////////////////////////////////////////////////////////////////////////
-void render(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config, const DisplayConfig& in_display_config)
+void paint_overdraw_layers(unsigned int in_nb_layers)
 {
-    // Set Projection Matrix
+    // Translucent full screen quads : pure fill rate cost, the model stays visible below
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TRANSFORM_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    glColor4d(1.0, 1.0, 1.0, OVERDRAW_LAYER_ALPHA);
+    glBegin(GL_QUADS);
+    for (unsigned int i = 0; i < in_nb_layers; ++i)
+    {
+        glVertex2d(-1.0, -1.0);
+        glVertex2d( 1.0, -1.0);
+        glVertex2d( 1.0,  1.0);
+        glVertex2d(-1.0,  1.0);
+    }
+    glEnd();
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glPopAttrib();
+}
+
+////////////////////////////////////////////////////////////////////////
+void render(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, const DisplayConfig& in_display_config)
+{
+    ScopedTrace trace("render");
+
+    // Set Projection Matrix, keep the aspect ratio of offscreen framebuffers
+    const double aspect_ratio = static_cast<double>(io_rendering_data.rendering_width) / static_cast<double>(io_rendering_data.rendering_height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    glFrustum(-0.1, 0.1, -0.1, 0.1, 0.1, 40.0);
+    glFrustum(-0.1 * aspect_ratio, 0.1 * aspect_ratio, -0.1, 0.1, 0.1, 40.0);
+
+    // Multisampled frames are drawn aside then resolved into the offscreen framebuffer
+    begin_multisample_frame(io_rendering_data.multisample);
 
     // Set Modelview Matrix
     glMatrixMode(GL_MODELVIEW);
@@ -935,21 +4664,55 @@ void render(const RenderingData& in_rendering_data, const RenderingConfig& in_re
     glTranslated(0.0, 0.0, in_display_config.move_forward);
 
     // Ligthing
-    GLfloat light_position[] = {0.0f, 2.0f, 1.0f, 0.0f};
-    glLightfv(GL_LIGHT0, GL_POSITION, light_position);
+    position_lights(in_rendering_config);
 
     // Modelview matrix rotation
     glRotated(in_display_config.rotation_angle_y, 0.0, 1.0, 0.0);
     glRotated(in_display_config.rotation_angle_x, 1.0, 0.0, 0.0);
 
-    // Painting
+    if (in_rendering_config.rendering_method == STREAMING_VBO)
+    {
+        ++io_rendering_data.streaming.nb_frames;
+    }
+
+    // Painting, each overdraw pass draws the model again unless the layers are full screen quads
+    const bool full_screen_overdraw = in_rendering_config.rendering_options.test(FULL_SCREEN_OVERDRAW);
+    const unsigned int nb_model_passes = full_screen_overdraw ? 1 : in_rendering_config.nb_overdraw_passes;
+    for (unsigned int i = 0; i < nb_model_passes; ++i)
+    {
+        if (in_rendering_config.nb_scene_objects > 1)
+        {
+            ScopedTrace pass_trace("draw_scene");
+            draw_scene(io_rendering_data, in_rendering_config);
+        }
+        else
+        {
+            ScopedTrace pass_trace("draw_model");
+            draw_model(io_rendering_data, in_rendering_config);
+        }
+    }
+    if (full_screen_overdraw && in_rendering_config.nb_overdraw_passes > 1)
+    {
+        ScopedTrace layers_trace("overdraw layers");
+        paint_overdraw_layers(in_rendering_config.nb_overdraw_passes - 1);
+    }
+
+    resolve_multisample_frame(io_rendering_data, in_rendering_config);
+}
+
+////////////////////////////////////////////////////////////////////////
+void draw_model(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
     if (in_rendering_config.rendering_method == IMMEDIATE)
     {
-        paint_gl(in_rendering_data.geometry, in_rendering_config);
+        paint_gl(model_geometry(io_rendering_data), in_rendering_config);
     }
     else if (in_rendering_config.rendering_method == CALL_LIST)
     {
-        glCallList(in_rendering_data.call_list_id);
+        for (unsigned int i = 0; i < io_rendering_data.nb_call_lists; ++i)
+        {
+            glCallList(io_rendering_data.call_list_id + i);
+        }
     }
     else if (in_rendering_config.rendering_method == DYNAMIC_VBO || in_rendering_config.rendering_method == STATIC_VBO)
     {
@@ -958,8 +4721,9 @@ void render(const RenderingData& in_rendering_data, const RenderingConfig& in_re
             glColor3d(1.0, 1.0, 1.0);
         }
 
+        const Geometry& geometry = model_geometry(io_rendering_data);
         size_t offset = 0;
-        for (std::list<TriangleStrip>::const_iterator it = in_rendering_data.geometry.triangles_strip.begin(); it != in_rendering_data.geometry.triangles_strip.end(); ++it)
+        for (std::list<TriangleStrip>::const_iterator it = geometry.triangles_strip.begin(); it != geometry.triangles_strip.end(); ++it)
         {
             if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
             {
@@ -975,24 +4739,118 @@ void render(const RenderingData& in_rendering_data, const RenderingConfig& in_re
             }
         }
     }
-
-    glFlush();
-    SDL_GL_SwapBuffers();
+    else if (in_rendering_config.rendering_method == STREAMING_VBO)
+    {
+        stream_model(io_rendering_data, in_rendering_config);
+    }
+    else if (in_rendering_config.rendering_method == GPU_CULLED)
+    {
+        // The command buffer is written by the GPU, the CPU only issues the dispatch and one draw
+        CullingData& culling_data = io_rendering_data.culling;
+        if (culling_data.program_id)
+        {
+            if (!in_rendering_config.rendering_options.test(COLOR))
+            {
+                glColor3d(1.0, 1.0, 1.0);
+            }
+            const GLenum mode = in_rendering_config.rendering_options.test(TRIANGLE_STRIP) ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+            cull_clusters(culling_data);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culling_data.command_buffer_id);
+            glMultiDrawElementsIndirect(mode, GL_UNSIGNED_INT, NULL, culling_data.nb_clusters, 0);
+        }
+    }
+    else if (in_rendering_config.rendering_method == PROCEDURAL)
+    {
+        // No array is enabled, the vertex shader only reads gl_VertexID
+        const ProceduralData& procedural_data = io_rendering_data.procedural;
+        if (procedural_data.program_id)
+        {
+            const GLenum mode = in_rendering_config.rendering_options.test(TRIANGLE_STRIP) ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+            glUseProgram(procedural_data.program_id);
+            glMultiDrawArrays(mode, &procedural_data.strip_firsts[0], &procedural_data.strip_counts[0], procedural_data.strip_firsts.size());
+            glUseProgram(0);
+        }
+    }
 }
 
-//////////////////////////////////////////////////////////////////////////////
-void generate_bench_rendering_config_list(std::deque< RenderingConfig >& in_rendering_config_list, unsigned int in_nb_triangles)
+////////////////////////////////////////////////////////////////////////
+unsigned int draw_model_nb_draws(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config)
 {
-    for (unsigned int rendering_method = IMMEDIATE; rendering_method < NB_RENDERING_METHOD; ++rendering_method)
+    // glCallList per list, or one glBegin / glDrawElements per strip, the immediate triangles share one glBegin
+    if (in_rendering_config.rendering_method == CALL_LIST)
+    {
+        return in_rendering_data.nb_call_lists;
+    }
+    if ((in_rendering_config.rendering_method == IMMEDIATE && !in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
+        ||
+        in_rendering_config.rendering_method == PROCEDURAL || in_rendering_config.rendering_method == GPU_CULLED)
+    {
+        return 1;
+    }
+    if (in_rendering_config.rendering_method == STREAMING_VBO)
     {
-        for (unsigned int rendering_options = 0 ; rendering_options != (1U << NB_BENCH_RENDERING_OPTION); ++rendering_options)
+        // One glDrawElements per strip, or per chunk for the triangles
+        const StreamingData& streaming_data = in_rendering_data.streaming;
+        if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP) || !streaming_data.nb_chunk_rows)
         {
-            RenderingConfig rendering_config;
-            rendering_config.nb_triangles = in_nb_triangles;
-            rendering_config.rendering_method = static_cast<RenderingMethod> (rendering_method);
-            rendering_config.rendering_options = rendering_options;
+            return streaming_data.nb_subdivisions;
+        }
+        return (streaming_data.nb_subdivisions + streaming_data.nb_chunk_rows - 1) / streaming_data.nb_chunk_rows;
+    }
+    return model_geometry(in_rendering_data).triangles_strip.size();
+}
 
-            in_rendering_config_list.push_back(rendering_config);
+////////////////////////////////////////////////////////////////////////
+void draw_scene(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config)
+{
+    static const GLfloat materials[SCENE_NB_MATERIALS][4] = {{0.0f, 0.0f, 0.0f, 1.0f}, {0.3f, 0.0f, 0.0f, 1.0f},
+                                                             {0.0f, 0.3f, 0.0f, 1.0f}, {0.0f, 0.0f, 0.3f, 1.0f},
+                                                             {0.3f, 0.3f, 0.0f, 1.0f}, {0.0f, 0.3f, 0.3f, 1.0f},
+                                                             {0.3f, 0.0f, 0.3f, 1.0f}, {0.3f, 0.3f, 0.3f, 1.0f}};
+
+    // Naive submission sets every state of every object, sorted submission only the ones that change
+    const bool sorted_scene = in_rendering_config.rendering_options.test(SORTED_SCENE);
+    const SceneObject* p_previous_object = NULL;
+    for (std::vector<SceneObject>::const_iterator it = io_rendering_data.scene_objects.begin(); it != io_rendering_data.scene_objects.end(); ++it)
+    {
+        const SceneObject& object = *it;
+        const unsigned int state_changes = scene_state_changes(sorted_scene ? p_previous_object : NULL, object);
+        if (state_changes & SCENE_TEXTURE_CHANGE)
+        {
+            if (object.texture)
+                glEnable(GL_TEXTURE_2D);
+            else
+                glDisable(GL_TEXTURE_2D);
         }
+        if (state_changes & SCENE_CULLING_CHANGE)
+        {
+            if (object.culling)
+                glEnable(GL_CULL_FACE);
+            else
+                glDisable(GL_CULL_FACE);
+        }
+        if (state_changes & SCENE_MATERIAL_CHANGE)
+        {
+            glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, materials[object.material_id]);
+        }
+
+        glPushMatrix();
+        glTranslated(object.position.x, object.position.y, object.position.z);
+        glScaled(object.scale, object.scale, object.scale);
+        draw_model(io_rendering_data, in_rendering_config);
+        glPopMatrix();
+
+        p_previous_object = &object;
     }
+
+    // Back to the state set by init_gl
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+        glEnable(GL_TEXTURE_2D);
+    else
+        glDisable(GL_TEXTURE_2D);
+    if (in_rendering_config.rendering_options.test(BACK_FACE_PAINTING))
+        glDisable(GL_CULL_FACE);
+    else
+        glEnable(GL_CULL_FACE);
+    glMaterialfv(GL_FRONT_AND_BACK, GL_EMISSION, materials[0]);
 }
@@ -19,149 +19,386 @@
 
 #include <deque>
 #include <bitset>
+#include <map>
+#include <string>
+
+#include "geometry.h"
+#include "config.h"
+#include "packing.h"
+#include "stats.h"
+#include "gl_counters.h"
 
 ////////////////////////////////////////////////////////////////////////
-// Vector structure
 ////////////////////////////////////////////////////////////////////////
-struct Vector3d
+enum EventType
 {
-    // methods
-    Vector3d() {}
-    Vector3d(double in_x, double in_y, double in_z) : x(in_x), y(in_y), z(in_z) {}
-    inline Vector3d operator+(const Vector3d& in_v) const { return Vector3d(x + in_v.x, y + in_v.y, z + in_v.z); }
-    inline Vector3d operator-(const Vector3d& in_v) const { return Vector3d(x - in_v.x, y - in_v.y, z - in_v.z); }
-    inline Vector3d operator*(double in_a) const { return Vector3d(x * in_a, y * in_a, z * in_a); }
-    inline Vector3d operator/(double in_a) const { return Vector3d(x / in_a, y / in_a, z / in_a); }
-
-    // members
-    double x, y, z;
+    NO_EVENT,
+    QUIT_REQUESTED,
+    BENCH_REQUESTED,
+    RENDERING_CONFIG_CHANGED,
+    BENCH_CONFIG_CHANGED,
+    DISPLAY_CONFIG_CHANGED
 };
 
 ////////////////////////////////////////////////////////////////////////
-// Model structure
+// Data structure
 ////////////////////////////////////////////////////////////////////////
-struct Vertex
+struct ReadbackData
 {
-    Vector3d coord;
-    Vector3d normal;
-    Vector3d color;
-    Vector3d texture_coordinate;
+    unsigned int width;
+    unsigned int height;
+    size_t frame_size;                      // bytes read per frame
+    unsigned int frame_id;
+    std::vector<GLuint> pixel_buffer_ids;   // ring of pixel buffers (PBO_READBACK)
+    std::vector<GLsync> fences;             // one fence per pixel buffer, signaled when its read is done
+    std::vector<unsigned char> pixels;      // destination of the synchronous read
+    std::ofstream capture_stream;
+    std::deque<long> readback_times;        // time spent in readback per frame (us)
 };
 
-struct TriangleStrip
+struct SetupTimes
 {
-    std::vector<unsigned int> vertex_ids;
+    long generate_model;                    // us
+    long texturing;
+    long call_list;
+    long vbo_packing;
+    long vbo_upload;
+    long shader_build;
+    long first_frame;
 };
 
-struct Geometry
+// State changes between two scene objects
+enum SceneStateChange
 {
-    std::vector<Vertex> vertices;
-    std::list<TriangleStrip> triangles_strip;
+    SCENE_TEXTURE_CHANGE  = 1 << 0,
+    SCENE_CULLING_CHANGE  = 1 << 1,
+    SCENE_MATERIAL_CHANGE = 1 << 2
 };
 
-////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////
-enum EventType
+struct SceneObject
 {
-    NO_EVENT,
-    QUIT_REQUESTED,
-    BENCH_REQUESTED,
-    RENDERING_CONFIG_CHANGED
+    Vector3d position;
+    double scale;
+    bool texture;
+    bool culling;
+    unsigned int material_id;
 };
 
+// Out of core model : never generated as a whole, each chunk of rows is generated and
+// packed into the next buffer pair of a ring, then drawn while the next chunk is packed
+struct StreamingData
+{
+    unsigned int nb_subdivisions;           // grid of the whole model
+    unsigned int nb_chunk_rows;             // strips per chunk
+    std::vector<GLuint> vertex_buffer_ids;  // ring of vertex and index buffers
+    std::vector<GLuint> index_buffer_ids;
+    std::vector<GLsync> fences;             // one fence per buffer pair, signaled when its draws are done
+    unsigned int next_buffer;
+    size_t vertex_buffer_size;              // bytes of each buffer of the ring
+    size_t index_buffer_size;
+    size_t ring_size;                       // bytes
+    Geometry chunk_geometry;                // rows of the chunk, with a row of margin on each side for the normals
+    // Totals since the first frame of the config
+    unsigned int nb_frames;
+    size_t uploaded_size;                   // bytes
+    long generate_time;                     // us
+    long upload_time;
+    long wait_time;
+    unsigned int nb_orphaned_chunks;        // streamed into orphaned storage, without a fence or after a fence timeout
+    unsigned int nb_failed_chunks;          // not drawn, a buffer of the pair could not be mapped
+};
 
-////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////
-enum RenderingMethod
+// Procedural model : the vertex shader evaluates each vertex from gl_VertexID, one glMultiDrawArrays draws every strip
+struct ProceduralData
 {
-    INVALID = 0,
-    IMMEDIATE,
-    CALL_LIST,
-    STATIC_VBO,
-    DYNAMIC_VBO,
+    GLuint program_id;
+    std::vector<GLint> strip_firsts;        // first vertex id and vertex count of each strip
+    std::vector<GLsizei> strip_counts;
+};
 
-    NB_RENDERING_METHOD
+// GPU culling : a compute shader tests every cluster of the static VBO against the frustum and, with face culling,
+// its normal cone against the view, then writes one indirect draw command per cluster (no instance when culled)
+struct CullingData
+{
+    GLuint program_id;
+    GLint frustum_planes_location;
+    GLint eye_position_location;
+    GLint cone_culling_location;
+    GLuint cluster_buffer_id;               // ClusterBounds of every cluster
+    GLuint command_buffer_id;               // DrawElementsIndirectCommand of every cluster
+    GLuint counter_buffer_id;               // frustum and back-facing culled clusters, accumulated since the first frame
+    GLuint counter_copy_buffer_id;          // counters copied when the fence is placed, only read once it is signaled
+    unsigned int nb_clusters;
+    size_t buffers_size;                    // bytes
+    // Counters are copied with a fence and the copy read once the GPU is past it, never waited for
+    unsigned int nb_dispatches;
+    GLsync counter_fence;
+    unsigned int nb_fenced_dispatches;
+    unsigned int nb_read_dispatches;        // dispatches counted by the last read
+    unsigned long nb_frustum_culled;
+    unsigned long nb_cone_culled;
 };
 
-////////////////////////////////////////////////////////////////////////
-////////////////////////////////////////////////////////////////////////
-enum RenderingOption
+// Multisampled offscreen framebuffer : the frame is drawn in it then resolved into the single sampled framebuffer,
+// GPU timestamps around the draw and the resolve are read back a few frames later
+struct MultisampleData
 {
-    TRIANGLE_STRIP = 0,
-    COLOR,
-    TEXTURE,
-    SMOOTH_SHADING,
-    BACK_FACE_PAINTING,
+    GLuint framebuffer_id;
+    GLuint color_renderbuffer_id;
+    GLuint depth_renderbuffer_id;
+    unsigned int nb_samples;                // supported samples, 1 when the frame is drawn in the single sampled framebuffer
+    std::vector<GLuint> query_ids;          // draw begin, resolve begin and resolve end of each frame in flight
+    unsigned int first_pending_query;
+    unsigned int nb_pending_queries;
+    bool frame_open;
+    std::deque<long> draw_times;            // GPU time per frame (ns)
+    std::deque<long> resolve_times;
+};
 
-    NB_BENCH_RENDERING_OPTION,
+struct RenderingData
+{
+    Geometry geometry;
+    const Geometry* p_shared_geometry;      // model of another RenderingData read in place of geometry (thread bench workers)
+    unsigned int model_nb_triangles;        // triangles requested for the current geometry
+    bool model_in_memory;                   // geometry left empty when the model is streamed or procedural
+    StreamingData streaming;
+    ProceduralData procedural;
+    CullingData culling;
+    std::vector<SceneObject> scene_objects;
+    unsigned int scene_nb_draws;            // per frame
+    unsigned int scene_nb_state_changes;
+    unsigned int rendering_width;           // size of the window or of the offscreen framebuffer
+    unsigned int rendering_height;
+    GLuint framebuffer_id;
+    GLuint color_renderbuffer_id;
+    GLuint depth_renderbuffer_id;
+    MultisampleData multisample;
+    GLuint texture_id;
+    GLuint call_list_id;                    // first list of nb_call_lists consecutive lists
+    unsigned int nb_call_lists;
+    size_t call_list_size;                  // process memory taken by the compilation (bytes)
+    GLuint index_buffer_id;
+    GLuint vertex_buffer_id;
+    size_t index_buffer_size;               // bytes
+    size_t vertex_buffer_size;
+    ReadbackData readback;
+    SetupTimes setup_times;
+};
 
-    WIREFRAME,
+enum TraceTrack
+{
+    CPU_TRACK = 1,
+    GPU_TRACK
+};
 
-    NB_RENDERING_OPTION
+struct TraceEvent
+{
+    const char* name;                       // static string
+    long begin;                             // us since the trace start
+    long duration;                          // us
+    TraceTrack track;
 };
 
-////////////////////////////////////////////////////////////////////////
-// Config and Data structure
-////////////////////////////////////////////////////////////////////////
-struct DisplayConfig
+struct TraceData
 {
-    unsigned int windows_width;
-    unsigned int windows_height;
-    double rotation_angle_y;
-    double rotation_angle_x;
-    double move_forward;
-    bool rotation;
+    bool enabled;
+    struct timeval start_time;
+    std::vector<TraceEvent> events;
+    unsigned int nb_dropped_events;
+    // GPU frame intervals, from timestamp query pairs read back a few frames later
+    GLint64 gpu_start_time;                 // GL timestamp at the trace start (ns)
+    std::vector<GLuint> query_ids;
+    unsigned int first_pending_query;
+    unsigned int nb_pending_queries;
+    bool gpu_frame_open;
 };
 
-struct RenderingConfig
+// One rendering thread of the thread scaling bench, with its own context on a pbuffer
+struct ThreadBenchWorker
 {
-    RenderingMethod rendering_method;
-    unsigned int nb_triangles;
+    Display* p_display;
+    GLXPbuffer pbuffer;
+    GLXContext context;
+    const RenderingData* p_main_rendering_data;     // model, and objects of the main context when they are shared
+    bool shared_objects;
+    DisplayConfig display_config;
+    RenderingConfig rendering_config;
+    SDL_sem* p_ready_semaphore;
+    SDL_sem* p_start_semaphore;
+    bool success;
+    long rendering_time;                    // us for THREAD_BENCH_NB_FRAMES frames
+#ifdef GLBENCH_GL_COUNTERS
+    GlCounters gl_counters;                 // of the measured frames, counted by the thread
+#endif
+};
 
-    std::bitset<NB_RENDERING_OPTION> rendering_options;
+struct BenchResult
+{
+    RenderingConfig rendering_config;
+    unsigned int rendering_width;
+    unsigned int rendering_height;
+    double mean_rendering_time;             // us
 };
 
-struct RenderingData
+// Bench reports are checkpoints : each config is appended whole once done, after a line telling it was started,
+// so that an interrupted run resumes from its report and the reports of the shards of a matrix merge into one
+struct BenchRecord
 {
-    Geometry geometry;
-    GLuint texture_id;
-    GLuint call_list_id;
-    GLuint index_buffer_id;
-    GLuint vertex_buffer_id;
+    unsigned int config_id;                 // in the whole config matrix
+    unsigned int nb_configs;
+    std::string key;                        // rendering_config_key of the config
+    bool completed;                         // false when the config was skipped after crashing every attempt
+    BenchResult result;
+    std::string text;                       // config and results as printed
+};
+
+struct BenchReport
+{
+    std::string header;                     // display config and renderer
+    std::string matrix;                     // config matrix line of the header
+    std::string renderer;                   // last line of the header
+    std::vector<BenchRecord> records;
+    std::map<unsigned int, unsigned int> nb_started;    // attempts of each config id
+    std::map<unsigned int, std::string> started_lines;
+};
+
+// Records a CPU span in the trace and a matching GL debug group, nothing when the trace is disabled
+class ScopedTrace
+{
+public:
+    ScopedTrace(const char* in_name);
+    ~ScopedTrace();
+
+private:
+    const char* m_name;
+    bool m_enabled;
+    struct timeval m_start;
 };
 
 ////////////////////////////////////////////////////////////////////////
 // Functions
 ////////////////////////////////////////////////////////////////////////
-int main(int, char**);
-
-long elapsed_time(const struct timeval& in_start, const struct timeval& in_end);
-
+int main(int argc, char** argv);
+
+
+void start_trace(TraceData& io_trace_data);
+void stop_trace(TraceData& io_trace_data, const char* in_file_name);
+void add_trace_event(TraceData& io_trace_data, const char* in_name, long in_begin, long in_duration, TraceTrack in_track);
+void begin_gpu_trace_frame(TraceData& io_trace_data);
+void end_gpu_trace_frame(TraceData& io_trace_data);
+void write_trace(const TraceData& in_trace_data, std::ostream& out_stream);
+
+bool parse_command_line(int argc, char** argv, BenchConfig& io_bench_config, bool& out_command_line_bench, unsigned int& out_nb_merged_shards);
+void print_usage(const char* in_program_name);
+
+std::string bench_renderer_line();
+std::string bench_matrix_line(const std::deque<RenderingConfig>& in_rendering_config_list);
+std::string bench_config_line(const char* in_tag, unsigned int in_config_id, unsigned int in_nb_configs, const RenderingConfig& in_rendering_config);
+bool append_bench_report(const std::string& in_file_name, const std::string& in_text);
+bool write_bench_report(const std::string& in_file_name, const BenchReport& in_bench_report);
+bool read_bench_report(const std::string& in_file_name, BenchReport& out_bench_report);
+bool prepare_bench_report(const std::string& in_file_name, const BenchConfig& in_bench_config, std::deque<RenderingConfig>& io_rendering_config_list,
+                          std::deque<unsigned int>& out_config_ids, std::deque<BenchResult>& out_bench_results);
+long bench_config_time_budget(const BenchConfig& in_bench_config, const struct timeval& in_bench_start_time, const struct timeval& in_config_start_time,
+                              unsigned int in_nb_remaining_configs);
+void print_bench_summary(std::ostream& out_stream, BenchType in_bench_type, const std::deque<BenchResult>& in_bench_results);
+bool merge_bench_reports(const BenchConfig& in_bench_config, unsigned int in_nb_shards);
+
+void set_camera(DisplayConfig& io_display_config, unsigned int in_frame_id);
+void init_rendering_data(RenderingData& out_rendering_data, const DisplayConfig& in_display_config);
+const Geometry& model_geometry(const RenderingData& in_rendering_data);
 void init_sdl(const DisplayConfig& in_display_config);
 void init_gl_extensions();
+void set_swap_interval(SwapControl in_swap_control);
 void init_gl(RenderingData& in_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config);
+void set_gl_state(const RenderingConfig& in_rendering_config);
+void set_lights(const RenderingConfig& in_rendering_config);
+void position_lights(const RenderingConfig& in_rendering_config);
+
+bool is_gl_extension_supported(const char* in_extension_name);
+
+EventType event_sdl(DisplayConfig& io_display_config, RenderingConfig& io_rendering_config, BenchConfig& io_bench_config);
 
-EventType event_sdl(DisplayConfig& io_display_config, RenderingConfig& io_rendering_config);
+void print_readback_time(std::ostream& out_stream, const ReadbackData& in_readback_data, const RenderingConfig& in_rendering_config);
+double frame_nb_pixels(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config);
+void print_fill_rate_summary(std::ostream& out_stream, const std::deque<BenchResult>& in_bench_results);
+void print_lighting_summary(std::ostream& out_stream, const std::deque<BenchResult>& in_bench_results);
 
-void print_config(const RenderingConfig& in_rendering_config, std::ostream& out_stream);
-void print_rendering_time (std::ostream& out_stream, unsigned int in_nb_triangles, const std::deque<long>& in_rendering_times);
+void print_setup_times(std::ostream& out_stream, const SetupTimes& in_setup_times);
+
+void print_memory_usage(std::ostream& out_stream, const RenderingData& in_rendering_data);
+
+void process_scene(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+bool scene_object_less(const SceneObject& in_object1, const SceneObject& in_object2);
+unsigned int scene_state_changes(const SceneObject* in_p_previous_object, const SceneObject& in_object);
+unsigned int draw_model_nb_draws(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config);
+void draw_scene(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void print_scene_stats(std::ostream& out_stream, const RenderingData& in_rendering_data, const std::deque<long>& in_rendering_times);
 
-Vector3d compute_normal(const Vector3d& in_v1, const Vector3d& in_v2, const Vector3d& in_v3);
-void fill_normal(std::vector<Vertex>& out_vertices, unsigned int in_id1, unsigned int in_id2, unsigned int in_id3);
 void generate_model(const RenderingConfig& in_rendering_config, RenderingData& out_rendering_data);
 
+GLenum texture_internal_format(TextureFormat in_texture_format);
+GLenum texture_pixel_type(TextureFormat in_texture_format);
+unsigned int texture_pixel_size(TextureFormat in_texture_format);
+void generate_texture(unsigned int in_texture_size, TextureFormat in_texture_format, std::vector<unsigned char>& out_texture_data);
 void process_texturing(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
 void delete_texturing(RenderingData& io_rendering_data);
+bool compress_texture(unsigned int in_texture_size, const std::vector<unsigned char>& in_texture_data, std::vector<unsigned char>& out_compressed_data, GLenum& out_compressed_format);
+double upload_texture(TextureUploadMethod in_upload_method, unsigned int in_texture_size, TextureFormat in_texture_format, GLenum in_internal_format, const std::vector<unsigned char>& in_texture_data);
+void bench_texture_upload(std::ostream& out_stream);
+void bench_thread_scaling(std::ostream& out_stream, const RenderingData& in_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config);
+int thread_bench_worker(void* io_p_worker);
+bool bench_validation(std::ostream& out_stream, RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config);
+void read_frame(const RenderingData& in_rendering_data, std::vector<unsigned char>& out_pixels);
+double image_psnr(const std::vector<unsigned char>& in_reference_pixels, const std::vector<unsigned char>& in_pixels, unsigned int& out_nb_different_pixels);
 
 void process_call_list(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void compile_vertex_array_call_lists(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
 void delete_call_list(RenderingData& io_rendering_data);
 
+void upload_vertex_buffer(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, GLenum in_usage);
+void upload_index_buffer(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, GLenum in_usage);
+void enable_vbo_client_state(const RenderingConfig& in_rendering_config);
 void process_vbo(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
 void delete_vbo(RenderingData& io_rendering_data);
 
+void process_streaming(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void delete_streaming(RenderingData& io_rendering_data);
+void clear_streaming_stats(StreamingData& out_streaming_data);
+void stream_model(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void print_streaming_stats(std::ostream& out_stream, const StreamingData& in_streaming_data, const std::deque<long>& in_rendering_times);
+
+GLuint compile_shader(GLenum in_shader_type, const char* in_source);
+GLuint link_program(GLuint in_shader_id);
+void process_procedural(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void delete_procedural(RenderingData& io_rendering_data);
+
+void process_culling(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void delete_culling(RenderingData& io_rendering_data);
+void clear_culling_stats(CullingData& io_culling_data);
+void compute_culling_view(GLfloat* out_frustum_planes, GLfloat* out_eye_position);
+void cull_clusters(CullingData& io_culling_data);
+void print_culling_stats(std::ostream& out_stream, const CullingData& in_culling_data);
+
+void process_framebuffer(RenderingData& io_rendering_data, const DisplayConfig& in_display_config, const RenderingConfig& in_rendering_config);
+void delete_framebuffer(RenderingData& io_rendering_data);
+GLenum depth_internal_format(DepthFormat in_depth_format);
+void process_multisample(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void delete_multisample(MultisampleData& io_multisample_data);
+void clear_multisample_stats(MultisampleData& io_multisample_data);
+void begin_multisample_frame(MultisampleData& io_multisample_data);
+void resolve_multisample_frame(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void print_multisample_times(std::ostream& out_stream, const MultisampleData& in_multisample_data);
+
+void process_readback(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void delete_readback(RenderingData& io_rendering_data);
+void readback_frame(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void consume_readback_frame(ReadbackData& io_readback_data, const RenderingConfig& in_rendering_config, const unsigned char* in_pixels);
+
 void paint_gl(const Geometry& in_geometry, const RenderingConfig& in_rendering_config);
 void paint_gl(const RenderingConfig& in_rendering_config, const Vertex& in_vertex);
 
-void render(const RenderingData& in_rendering_data, const RenderingConfig& in_rendering_config, const DisplayConfig& in_display_config);
+void paint_overdraw_layers(unsigned int in_nb_layers);
+void draw_model(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config);
+void render(RenderingData& io_rendering_data, const RenderingConfig& in_rendering_config, const DisplayConfig& in_display_config);
 
-void generate_bench_rendering_config_list(std::deque<RenderingConfig>& in_rendering_config_list, unsigned int in_nb_triangles);
@@ -0,0 +1,204 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <list>
+
+#include <sys/time.h>
+
+#include <GL/gl.h>
+
+#include "microbench.h"
+
+// CPU micro benchmark of the glbench core : no window and no GL context,
+// the GL header only gives the buffer types
+
+const unsigned int MICROBENCH_SIZES[] = {32000, 320000, 3200000};
+const unsigned int NB_MICROBENCH_SIZES = sizeof(MICROBENCH_SIZES) / sizeof(MICROBENCH_SIZES[0]);
+
+const unsigned int MICROBENCH_NB_RUNS = 5;              // median of the runs is reported
+const unsigned int MICROBENCH_STATS_ITERATIONS = 10000; // stats calls per run of the stats kernel
+
+const char* MICROBENCH_FILE = "microbench.txt";
+
+const MicrobenchKernel MICROBENCH_KERNELS[] = {
+    {"generate_geometry",       run_generate_geometry,      true},
+    {"compute_normals",         run_compute_normals,        true},
+    {"pack_vertex_buffer",      run_pack_vertex_buffer,     true},
+    {"pack_strip_indices",      run_pack_strip_indices,     true},
+    {"pack_triangle_indices",   run_pack_triangle_indices,  true},
+    {"pack_clusters",           run_pack_clusters,          true},
+    {"rendering_stats",         run_rendering_stats,        false}
+};
+const unsigned int NB_MICROBENCH_KERNELS = sizeof(MICROBENCH_KERNELS) / sizeof(MICROBENCH_KERNELS[0]);
+
+////////////////////////////////////////////////////////////////////////
+int main(int argc, char** argv)
+{
+    // The commit is given by the makefile, results of every commit are appended to the same file
+    const char* commit = argc > 1 ? argv[1] : "unknown";
+
+    std::ofstream microbench_stream(MICROBENCH_FILE, std::ios::app);
+
+    std::cout << "X--------------------------------------------------X" << std::endl;
+    std::cout << "|              GlBench micro benchmark             |" << std::endl;
+    std::cout << "X--------------------------------------------------X" << std::endl;
+    std::cout << "commit " << commit << ", median of " << MICROBENCH_NB_RUNS << " runs" << std::endl;
+
+    for (unsigned int i = 0; i < NB_MICROBENCH_SIZES; ++i)
+    {
+        MicrobenchData microbench_data;
+        init_microbench_data(microbench_data, MICROBENCH_SIZES[i]);
+
+        std::cout << std::endl << microbench_data.nb_triangles << " triangles" << std::endl;
+
+        for (unsigned int j = 0; j < NB_MICROBENCH_KERNELS; ++j)
+        {
+            const long median_run_time = time_kernel(MICROBENCH_KERNELS[j], microbench_data);
+
+            std::cout << " - " << std::setw(24) << std::left << MICROBENCH_KERNELS[j].name << std::right;
+            print_fixed(std::cout, median_run_time / 1000.0, 2);
+            std::cout << " ms";
+            if (MICROBENCH_KERNELS[j].per_triangle && median_run_time > 0)
+            {
+                std::cout << " (";
+                print_fixed(std::cout, static_cast<double>(microbench_data.nb_triangles) / median_run_time, 2);
+                std::cout << " Mtri/s)";
+            }
+            std::cout << std::endl;
+
+            microbench_stream << commit << ' ' << MICROBENCH_KERNELS[j].name << ' ' << microbench_data.nb_triangles << ' ' << median_run_time << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "Results appended to " << MICROBENCH_FILE << std::endl;
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+void init_microbench_data(MicrobenchData& out_microbench_data, unsigned int in_nb_triangles)
+{
+    out_microbench_data.nb_triangles = in_nb_triangles;
+
+    // Only the options read by the packing matter, the vertex buffer is packed with every attribute
+    RenderingConfig& rendering_config = out_microbench_data.rendering_config;
+    rendering_config.rendering_method = STATIC_VBO;
+    rendering_config.nb_triangles = in_nb_triangles;
+    rendering_config.call_list_build = REPLAY_CALL_LIST;
+    rendering_config.rendering_options.reset();
+    rendering_config.rendering_options.set(COLOR);
+    rendering_config.rendering_options.set(TEXTURE);
+    rendering_config.texture_size = TEXTURE_SIZES[0];
+    rendering_config.texture_format = TEXTURE_RGBA8;
+    rendering_config.texture_filter = TEXTURE_NEAREST;
+    rendering_config.readback_mode = NO_READBACK;
+    rendering_config.readback_format = READBACK_RGBA8;
+    rendering_config.framebuffer_width = 0;
+    rendering_config.framebuffer_height = 0;
+    rendering_config.nb_overdraw_passes = 1;
+    rendering_config.nb_scene_objects = 1;
+    rendering_config.nb_samples = 1;
+    rendering_config.depth_format = DEPTH_24;
+    rendering_config.nb_lights = 1;
+    rendering_config.light_type = DIRECTIONAL_LIGHT;
+
+    generate_geometry(in_nb_triangles, out_microbench_data.geometry);
+    compute_normals(out_microbench_data.geometry);
+
+    // Frame times around 10 ms, the stats only depend on their number
+    out_microbench_data.rendering_times.clear();
+    for (unsigned int i = 0; i < NB_MIN_FRAME; ++i)
+    {
+        out_microbench_data.rendering_times.push_front(10000 + static_cast<long>((i * 7919) % 1000));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+long time_kernel(const MicrobenchKernel& in_kernel, MicrobenchData& io_microbench_data)
+{
+    std::deque<long> run_times;
+    for (unsigned int i = 0; i < MICROBENCH_NB_RUNS; ++i)
+    {
+        struct timeval start;
+        struct timeval end;
+        gettimeofday(&start, NULL);
+        in_kernel.p_run(io_microbench_data);
+        gettimeofday(&end, NULL);
+        run_times.push_front(elapsed_time_us(start, end));
+    }
+    return median_time(run_times);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_generate_geometry(MicrobenchData& io_microbench_data)
+{
+    generate_geometry(io_microbench_data.nb_triangles, io_microbench_data.geometry);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_compute_normals(MicrobenchData& io_microbench_data)
+{
+    compute_normals(io_microbench_data.geometry);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_pack_vertex_buffer(MicrobenchData& io_microbench_data)
+{
+    const Geometry& geometry = io_microbench_data.geometry;
+    io_microbench_data.vertex_buffer.resize(geometry.vertices.size() * nb_vertex_floats(io_microbench_data.rendering_config));
+    pack_vertex_buffer(geometry, io_microbench_data.rendering_config, 0, geometry.vertices.size(), &io_microbench_data.vertex_buffer[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_pack_strip_indices(MicrobenchData& io_microbench_data)
+{
+    io_microbench_data.rendering_config.rendering_options.set(TRIANGLE_STRIP);
+    io_microbench_data.index_buffer.resize(count_indices(io_microbench_data.geometry, io_microbench_data.rendering_config));
+    pack_index_buffer(io_microbench_data.geometry, io_microbench_data.rendering_config, &io_microbench_data.index_buffer[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_pack_triangle_indices(MicrobenchData& io_microbench_data)
+{
+    // Index expansion of every strip into separate triangles
+    io_microbench_data.rendering_config.rendering_options.reset(TRIANGLE_STRIP);
+    io_microbench_data.index_buffer.resize(count_indices(io_microbench_data.geometry, io_microbench_data.rendering_config));
+    pack_index_buffer(io_microbench_data.geometry, io_microbench_data.rendering_config, &io_microbench_data.index_buffer[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_pack_clusters(MicrobenchData& io_microbench_data)
+{
+    // Bounding spheres and normal cones of the GPU culling
+    io_microbench_data.clusters.resize(count_clusters(io_microbench_data.geometry));
+    pack_clusters(io_microbench_data.geometry, io_microbench_data.rendering_config, &io_microbench_data.clusters[0]);
+}
+
+////////////////////////////////////////////////////////////////////////
+void run_rendering_stats(MicrobenchData& io_microbench_data)
+{
+    std::ostringstream stats_stream;
+    for (unsigned int i = 0; i < MICROBENCH_STATS_ITERATIONS; ++i)
+    {
+        stats_stream.str("");
+        median_time(io_microbench_data.rendering_times);
+        print_rendering_time(stats_stream, io_microbench_data.nb_triangles, 0.0, io_microbench_data.rendering_times);
+    }
+}
@@ -0,0 +1,63 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <vector>
+#include <deque>
+
+#include <GL/gl.h>
+
+#include "geometry.h"
+#include "config.h"
+#include "packing.h"
+#include "stats.h"
+
+////////////////////////////////////////////////////////////////////////
+// Micro benchmark data, shared by every kernel run on one model size
+////////////////////////////////////////////////////////////////////////
+struct MicrobenchData
+{
+    unsigned int nb_triangles;
+    RenderingConfig rendering_config;
+    Geometry geometry;
+    std::vector<GLfloat> vertex_buffer;
+    std::vector<GLuint> index_buffer;
+    std::vector<ClusterBounds> clusters;
+    std::deque<long> rendering_times;       // fake frame times for the stats kernel (us)
+};
+
+struct MicrobenchKernel
+{
+    const char* name;
+    void (*p_run)(MicrobenchData& io_microbench_data);
+    bool per_triangle;                      // throughput reported in Mtri/s
+};
+
+////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////
+int main(int, char**);
+
+void init_microbench_data(MicrobenchData& out_microbench_data, unsigned int in_nb_triangles);
+long time_kernel(const MicrobenchKernel& in_kernel, MicrobenchData& io_microbench_data);
+
+void run_generate_geometry(MicrobenchData& io_microbench_data);
+void run_compute_normals(MicrobenchData& io_microbench_data);
+void run_pack_vertex_buffer(MicrobenchData& io_microbench_data);
+void run_pack_strip_indices(MicrobenchData& io_microbench_data);
+void run_pack_triangle_indices(MicrobenchData& io_microbench_data);
+void run_pack_clusters(MicrobenchData& io_microbench_data);
+void run_rendering_stats(MicrobenchData& io_microbench_data);
@@ -0,0 +1,236 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include <list>
+#include <cmath>
+#include <algorithm>
+
+#include <GL/gl.h>
+
+#include "packing.h"
+
+////////////////////////////////////////////////////////////////////////
+unsigned int nb_vertex_floats(const RenderingConfig& in_rendering_config)
+{
+    unsigned int vertex_data_size = 6;
+    if (in_rendering_config.rendering_options.test(COLOR))
+    {
+        vertex_data_size += 3;
+    }
+    if (in_rendering_config.rendering_options.test(TEXTURE))
+    {
+        vertex_data_size += 3;
+    }
+    return vertex_data_size;
+}
+
+////////////////////////////////////////////////////////////////////////
+void pack_vertex_buffer(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, unsigned int in_first_vertex, unsigned int in_nb_vertices, GLfloat* out_vertex_buffer)
+{
+    unsigned int offset = 0;
+    for (unsigned int i = in_first_vertex; i < in_first_vertex + in_nb_vertices; ++i)
+    {
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).coord.x);
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).coord.y);
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).coord.z);
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).normal.x);
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).normal.y);
+        out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).normal.z);
+        if (in_rendering_config.rendering_options.test(COLOR))
+        {
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).color.x);
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).color.y);
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).color.z);
+        }
+        if (in_rendering_config.rendering_options.test(TEXTURE))
+        {
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).texture_coordinate.x);
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).texture_coordinate.y);
+            out_vertex_buffer[offset++] = static_cast<GLfloat> (in_geometry.vertices.at(i).texture_coordinate.z);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int count_strip_indices(const TriangleStrip& in_triangle_strip, const RenderingConfig& in_rendering_config)
+{
+    if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
+    {
+        return in_triangle_strip.vertex_ids.size();
+    }
+    return (in_triangle_strip.vertex_ids.size() - 2) * 3;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int count_indices(const Geometry& in_geometry, const RenderingConfig& in_rendering_config)
+{
+    unsigned int nb_index = 0;
+    for (std::list<TriangleStrip>::const_iterator it = in_geometry.triangles_strip.begin(); it != in_geometry.triangles_strip.end(); ++it)
+    {
+        nb_index += count_strip_indices(*it, in_rendering_config);
+    }
+    return nb_index;
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int pack_strip_indices(const TriangleStrip& in_triangle_strip, const RenderingConfig& in_rendering_config, GLuint* out_index_buffer)
+{
+    unsigned int offset = 0;
+    if (in_rendering_config.rendering_options.test(TRIANGLE_STRIP))
+    {
+        for (unsigned int j = 0; j < in_triangle_strip.vertex_ids.size(); ++j)
+        {
+            out_index_buffer[offset] = static_cast<GLuint>(in_triangle_strip.vertex_ids.at(j));
+            ++offset;
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < in_triangle_strip.vertex_ids.size() - 2; ++i)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+            {
+                if (i % 2 == 0)
+                {
+                    out_index_buffer[offset] = static_cast<GLuint>(in_triangle_strip.vertex_ids.at(i + j));
+                    ++offset;
+                }
+                else
+                {
+                    out_index_buffer[offset] = static_cast<GLuint>(in_triangle_strip.vertex_ids.at(i + 2 - j));
+                    ++offset;
+                }
+            }
+        }
+    }
+    return offset;
+}
+
+////////////////////////////////////////////////////////////////////////
+void pack_index_buffer(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, GLuint* out_index_buffer)
+{
+    unsigned int offset = 0;
+    for (std::list<TriangleStrip>::const_iterator it = in_geometry.triangles_strip.begin(); it != in_geometry.triangles_strip.end(); ++it)
+    {
+        offset += pack_strip_indices(*it, in_rendering_config, out_index_buffer + offset);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+unsigned int count_clusters(const Geometry& in_geometry)
+{
+    unsigned int nb_clusters = 0;
+    for (std::list<TriangleStrip>::const_iterator it = in_geometry.triangles_strip.begin(); it != in_geometry.triangles_strip.end(); ++it)
+    {
+        nb_clusters += ((*it).vertex_ids.size() - 2 + CLUSTER_NB_TRIANGLES - 1) / CLUSTER_NB_TRIANGLES;
+    }
+    return nb_clusters;
+}
+
+////////////////////////////////////////////////////////////////////////
+Vector3d strip_face_normal(const Geometry& in_geometry, const std::vector<unsigned int>& in_vertex_ids, unsigned int in_triangle_id)
+{
+    // Front faces are counter clockwise, every other triangle of a strip is flipped
+    const unsigned int first_id = (in_triangle_id % 2 == 0) ? in_triangle_id : in_triangle_id + 1;
+    const unsigned int second_id = (in_triangle_id % 2 == 0) ? in_triangle_id + 1 : in_triangle_id;
+    const Vector3d edge1 = in_geometry.vertices.at(in_vertex_ids[second_id]).coord - in_geometry.vertices.at(in_vertex_ids[first_id]).coord;
+    const Vector3d edge2 = in_geometry.vertices.at(in_vertex_ids[in_triangle_id + 2]).coord - in_geometry.vertices.at(in_vertex_ids[first_id]).coord;
+    const Vector3d normal(edge1.y * edge2.z - edge1.z * edge2.y,
+                          edge1.z * edge2.x - edge1.x * edge2.z,
+                          edge1.x * edge2.y - edge1.y * edge2.x);
+
+    // The degenerate triangles of the poles have no normal
+    const double length = sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+    return (length > 0.0) ? normal / length : Vector3d(0.0, 0.0, 0.0);
+}
+
+////////////////////////////////////////////////////////////////////////
+void pack_clusters(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, ClusterBounds* out_clusters)
+{
+    const bool triangle_strip = in_rendering_config.rendering_options.test(TRIANGLE_STRIP);
+
+    unsigned int cluster_id = 0;
+    unsigned int strip_first_index = 0;
+    for (std::list<TriangleStrip>::const_iterator it = in_geometry.triangles_strip.begin(); it != in_geometry.triangles_strip.end(); ++it)
+    {
+        const std::vector<unsigned int>& vertex_ids = (*it).vertex_ids;
+        const unsigned int nb_strip_triangles = vertex_ids.size() - 2;
+        for (unsigned int first_triangle = 0; first_triangle < nb_strip_triangles; first_triangle += CLUSTER_NB_TRIANGLES)
+        {
+            const unsigned int nb_triangles = std::min(CLUSTER_NB_TRIANGLES, nb_strip_triangles - first_triangle);
+            ClusterBounds& cluster = out_clusters[cluster_id++];
+
+            // Same ranges as pack_strip_indices : a sub strip, or 3 indices per triangle
+            cluster.first_index = strip_first_index + (triangle_strip ? first_triangle : 3 * first_triangle);
+            cluster.nb_indices = triangle_strip ? nb_triangles + 2 : 3 * nb_triangles;
+            cluster.padding[0] = 0;
+            cluster.padding[1] = 0;
+
+            // Bounding sphere around the center of the bounding box
+            Vector3d min_coord = in_geometry.vertices.at(vertex_ids[first_triangle]).coord;
+            Vector3d max_coord = min_coord;
+            for (unsigned int i = first_triangle; i < first_triangle + nb_triangles + 2; ++i)
+            {
+                const Vector3d& coord = in_geometry.vertices.at(vertex_ids[i]).coord;
+                min_coord = Vector3d(std::min(min_coord.x, coord.x), std::min(min_coord.y, coord.y), std::min(min_coord.z, coord.z));
+                max_coord = Vector3d(std::max(max_coord.x, coord.x), std::max(max_coord.y, coord.y), std::max(max_coord.z, coord.z));
+            }
+            const Vector3d center = (min_coord + max_coord) / 2.0;
+            double radius = 0.0;
+            for (unsigned int i = first_triangle; i < first_triangle + nb_triangles + 2; ++i)
+            {
+                const Vector3d offset = in_geometry.vertices.at(vertex_ids[i]).coord - center;
+                radius = std::max(radius, sqrt(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z));
+            }
+
+            // Normal cone of the front faces : mean direction, then the widest angle to it
+            Vector3d axis(0.0, 0.0, 0.0);
+            for (unsigned int i = first_triangle; i < first_triangle + nb_triangles; ++i)
+            {
+                axis = axis + strip_face_normal(in_geometry, vertex_ids, i);
+            }
+            double cone_sine = 2.0;
+            const double axis_length = sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+            if (axis_length > 0.0)
+            {
+                axis = axis / axis_length;
+                double min_cosine = 1.0;
+                for (unsigned int i = first_triangle; i < first_triangle + nb_triangles; ++i)
+                {
+                    const Vector3d normal = strip_face_normal(in_geometry, vertex_ids, i);
+                    if (normal.x != 0.0 || normal.y != 0.0 || normal.z != 0.0)
+                    {
+                        min_cosine = std::min(min_cosine, axis.x * normal.x + axis.y * normal.y + axis.z * normal.z);
+                    }
+                }
+                if (min_cosine > 0.0)
+                {
+                    cone_sine = sqrt(1.0 - min_cosine * min_cosine);
+                }
+            }
+
+            cluster.sphere[0] = static_cast<GLfloat>(center.x);
+            cluster.sphere[1] = static_cast<GLfloat>(center.y);
+            cluster.sphere[2] = static_cast<GLfloat>(center.z);
+            cluster.sphere[3] = static_cast<GLfloat>(radius);
+            cluster.cone[0] = static_cast<GLfloat>(axis.x);
+            cluster.cone[1] = static_cast<GLfloat>(axis.y);
+            cluster.cone[2] = static_cast<GLfloat>(axis.z);
+            cluster.cone[3] = static_cast<GLfloat>(cone_sine);
+        }
+        strip_first_index += count_strip_indices(*it, in_rendering_config);
+    }
+}
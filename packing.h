@@ -0,0 +1,49 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <GL/gl.h>
+
+#include "geometry.h"
+#include "config.h"
+
+// Strips are split into clusters of at most this many triangles, even so that strip clusters keep their winding
+const unsigned int CLUSTER_NB_TRIANGLES = 256;
+
+////////////////////////////////////////////////////////////////////////
+// Cluster of the GPU culling, std430 layout of the compute shader
+////////////////////////////////////////////////////////////////////////
+struct ClusterBounds
+{
+    GLfloat sphere[4];                      // center and radius
+    GLfloat cone[4];                        // normal cone axis, and sine of its half angle (> 1 when it never faces away)
+    GLuint first_index;                     // range of the cluster in the index buffer
+    GLuint nb_indices;
+    GLuint padding[2];
+};
+
+////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////
+unsigned int nb_vertex_floats(const RenderingConfig& in_rendering_config);
+void pack_vertex_buffer(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, unsigned int in_first_vertex, unsigned int in_nb_vertices, GLfloat* out_vertex_buffer);
+unsigned int count_strip_indices(const TriangleStrip& in_triangle_strip, const RenderingConfig& in_rendering_config);
+unsigned int count_indices(const Geometry& in_geometry, const RenderingConfig& in_rendering_config);
+unsigned int pack_strip_indices(const TriangleStrip& in_triangle_strip, const RenderingConfig& in_rendering_config, GLuint* out_index_buffer);
+void pack_index_buffer(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, GLuint* out_index_buffer);
+unsigned int count_clusters(const Geometry& in_geometry);
+Vector3d strip_face_normal(const Geometry& in_geometry, const std::vector<unsigned int>& in_vertex_ids, unsigned int in_triangle_id);
+void pack_clusters(const Geometry& in_geometry, const RenderingConfig& in_rendering_config, ClusterBounds* out_clusters);
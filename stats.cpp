@@ -0,0 +1,266 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <deque>
+#include <cmath>
+#include <algorithm>
+
+#include <sys/time.h>
+#include <stdio.h>
+
+#include "stats.h"
+
+////////////////////////////////////////////////////////////////////////
+long elapsed_time_us(const struct timeval& in_start, const struct timeval& in_end)
+{
+    long seconds  = in_end.tv_sec  - in_start.tv_sec;
+    long useconds = in_end.tv_usec - in_start.tv_usec;
+    return seconds * 1000000 + useconds;
+}
+
+////////////////////////////////////////////////////////////////////////
+ScopedTimer::ScopedTimer(long& io_time) : m_time(io_time)
+{
+    gettimeofday(&m_start, NULL);
+}
+
+////////////////////////////////////////////////////////////////////////
+ScopedTimer::~ScopedTimer()
+{
+    struct timeval end;
+    gettimeofday(&end, NULL);
+    m_time += elapsed_time_us(m_start, end);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_fixed(std::ostream& out_stream, double in_value, int in_nb_decimals)
+{
+    const std::ios_base::fmtflags flags = out_stream.flags();
+    const std::streamsize precision = out_stream.precision();
+    out_stream << std::fixed << std::setprecision(in_nb_decimals) << in_value;
+    out_stream.flags(flags);
+    out_stream.precision(precision);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+double mean_time(const std::deque<long>& in_times)
+{
+    double mean = 0.0;
+    for (std::deque<long>::const_iterator it = in_times.begin(); it != in_times.end(); ++it)
+    {
+        mean += static_cast<double>(*it);
+    }
+    return in_times.empty() ? 0.0 : mean / static_cast<double>(in_times.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_rendering_time (std::ostream& out_stream, unsigned int in_nb_triangles, double in_nb_pixels, const std::deque<long>& in_rendering_times)
+{
+    const double mean_rendering_time = mean_time(in_rendering_times);   // us, so triangles per us are Mtri/s
+
+    out_stream << in_nb_triangles << " triangles rendered in ";
+    print_fixed(out_stream, mean_rendering_time / 1000.0, 2);
+    out_stream << " ms";
+    if (in_rendering_times.size() < NB_MIN_FRAME)
+    {
+        out_stream << '*';
+    }
+    if (mean_rendering_time > 0.0)
+    {
+        out_stream << " (";
+        print_fixed(out_stream, in_nb_triangles / mean_rendering_time, 2);
+        out_stream << " Mtri/s, ";
+        print_fixed(out_stream, in_nb_pixels / mean_rendering_time, 2);
+        out_stream << " Mpixels/s)";
+    }
+    out_stream << "      " << std::flush;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+long median_time(const std::deque<long>& in_times)
+{
+    if (in_times.empty())
+    {
+        return 0;
+    }
+    std::vector<long> sorted_times(in_times.begin(), in_times.end());
+    std::nth_element(sorted_times.begin(), sorted_times.begin() + sorted_times.size() / 2, sorted_times.end());
+    return sorted_times[sorted_times.size() / 2];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+double median_relative_precision(const std::deque<long>& in_times)
+{
+    // Distribution free 95% confidence interval of the median, between the order statistics n/2 -/+ 1.96 sqrt(n) / 2
+    if (in_times.size() < 2)
+    {
+        return 1.0;
+    }
+    std::vector<long> sorted_times(in_times.begin(), in_times.end());
+    std::sort(sorted_times.begin(), sorted_times.end());
+
+    const double nb_times = static_cast<double>(sorted_times.size());
+    const double half_rank_width = 0.98 * sqrt(nb_times);
+    const size_t lower_rank = static_cast<size_t>(std::max(0.0, floor(nb_times / 2.0 - half_rank_width)));
+    const size_t upper_rank = static_cast<size_t>(std::min(nb_times - 1.0, ceil(nb_times / 2.0 + half_rank_width)));
+    const long median = sorted_times[sorted_times.size() / 2];
+    if (median <= 0)
+    {
+        return 0.0;
+    }
+    return (sorted_times[upper_rank] - sorted_times[lower_rank]) / (2.0 * median);
+}
+
+////////////////////////////////////////////////////////////////////////
+SamplingState sampling_state(const std::deque<long>& in_times, unsigned int in_min_frames, unsigned int in_max_frames, double in_target_precision,
+                             long in_elapsed_time, long in_time_budget)
+{
+    if (in_times.size() < in_min_frames)
+    {
+        return SAMPLING;
+    }
+    if (median_relative_precision(in_times) <= in_target_precision)
+    {
+        return SAMPLING_CONVERGED;
+    }
+    if (in_times.size() >= in_max_frames)
+    {
+        return SAMPLING_MAX_FRAMES;
+    }
+    if (in_elapsed_time >= in_time_budget)       // wall clock, setup and frame overhead included
+    {
+        return SAMPLING_TIME_BUDGET;
+    }
+    return SAMPLING;
+}
+
+////////////////////////////////////////////////////////////////////////
+void print_sampling(std::ostream& out_stream, const std::deque<long>& in_times, SamplingState in_sampling_state)
+{
+    out_stream << "| sampling : " << in_times.size() << " frames, median ";
+    print_fixed(out_stream, median_time(in_times) / 1000.0, 2);
+    out_stream << " ms +/- ";
+    print_fixed(out_stream, median_relative_precision(in_times) * 100.0, 1);
+    out_stream << " % (95% CI";
+    if (in_sampling_state == SAMPLING_MAX_FRAMES)
+        out_stream << ", not converged in the frame limit";
+    else if (in_sampling_state == SAMPLING_TIME_BUDGET)
+        out_stream << ", not converged in the time budget";
+    out_stream << ")      " << std::flush;
+}
+
+////////////////////////////////////////////////////////////////////////
+void clear_frame_pacing(FramePacing& out_frame_pacing)
+{
+    out_frame_pacing.has_last_present_time = false;
+    out_frame_pacing.frame_intervals.clear();
+    out_frame_pacing.latencies.clear();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void update_frame_pacing(FramePacing& io_frame_pacing, const struct timeval& in_input_time, const struct timeval& in_present_time)
+{
+    // The first frame only starts the interval measure
+    if (io_frame_pacing.has_last_present_time)
+    {
+        if (io_frame_pacing.frame_intervals.size() >= FRAME_PACING_WINDOW)
+        {
+            io_frame_pacing.frame_intervals.pop_back();
+        }
+        io_frame_pacing.frame_intervals.push_front(elapsed_time_us(io_frame_pacing.last_present_time, in_present_time));
+
+        if (io_frame_pacing.latencies.size() >= FRAME_PACING_WINDOW)
+        {
+            io_frame_pacing.latencies.pop_back();
+        }
+        io_frame_pacing.latencies.push_front(elapsed_time_us(in_input_time, in_present_time));
+    }
+    io_frame_pacing.last_present_time = in_present_time;
+    io_frame_pacing.has_last_present_time = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void print_frame_pacing(std::ostream& out_stream, const FramePacing& in_frame_pacing)
+{
+    if (in_frame_pacing.frame_intervals.empty())
+    {
+        return;
+    }
+
+    const double mean_interval = mean_time(in_frame_pacing.frame_intervals);
+    const long median_interval = median_time(in_frame_pacing.frame_intervals);
+
+    double variance = 0.0;
+    unsigned int nb_dropped_frames = 0;
+    for (std::deque<long>::const_iterator it = in_frame_pacing.frame_intervals.begin(); it != in_frame_pacing.frame_intervals.end(); ++it)
+    {
+        variance += (*it - mean_interval) * (*it - mean_interval);
+        if (*it > DROPPED_FRAME_RATIO * median_interval)
+        {
+            ++nb_dropped_frames;
+        }
+    }
+    variance = variance / static_cast<double>(in_frame_pacing.frame_intervals.size());
+
+    out_stream << "| interval ";
+    print_fixed(out_stream, mean_interval / 1000.0, 2);
+    out_stream << " +/- ";
+    print_fixed(out_stream, sqrt(variance) / 1000.0, 2);
+    out_stream << " ms, " << nb_dropped_frames << " dropped, latency ";
+    print_fixed(out_stream, mean_time(in_frame_pacing.latencies) / 1000.0, 2);
+    out_stream << " ms      " << std::flush;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void read_process_memory(size_t& out_rss, size_t& out_peak_rss)
+{
+    out_rss = 0;
+    out_peak_rss = 0;
+
+    FILE* p_status = fopen("/proc/self/status", "r");
+    if (p_status == NULL)
+    {
+        return;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), p_status))
+    {
+        unsigned long size = 0;     // kB
+        if (sscanf(line, "VmRSS: %lu", &size) == 1)
+        {
+            out_rss = size * 1024;
+        }
+        else if (sscanf(line, "VmHWM: %lu", &size) == 1)
+        {
+            out_peak_rss = size * 1024;
+        }
+    }
+    fclose(p_status);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+void reset_peak_rss()
+{
+    // Linux resets the peak RSS (VmHWM) to the current RSS, otherwise the peak is the one of the whole process
+    FILE* p_clear_refs = fopen("/proc/self/clear_refs", "w");
+    if (p_clear_refs)
+    {
+        fputs("5", p_clear_refs);
+        fclose(p_clear_refs);
+    }
+}
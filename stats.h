@@ -0,0 +1,86 @@
+//    This file is part of glBench.
+
+//    glBench is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+
+//    glBench is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with glBench.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <sys/time.h>
+
+#include <cstddef>
+#include <deque>
+#include <ostream>
+
+const unsigned int NB_MIN_FRAME = 30;
+
+// Adaptive sampling defaults
+const unsigned int MAX_SAMPLING_FRAMES = 1000;
+const double SAMPLING_TARGET_PRECISION = 0.01;
+const unsigned int BENCH_TIME_BUDGET = 600;     // s
+
+const unsigned int FRAME_PACING_WINDOW = 120;
+const double DROPPED_FRAME_RATIO = 1.5;     // a frame interval longer than 1.5 median intervals is a dropped frame
+
+////////////////////////////////////////////////////////////////////////
+// Adaptive sampling, a config is sampled until its median is precise enough
+////////////////////////////////////////////////////////////////////////
+enum SamplingState
+{
+    SAMPLING = 0,
+    SAMPLING_CONVERGED,
+    SAMPLING_MAX_FRAMES,                    // stopped before the target precision
+    SAMPLING_TIME_BUDGET
+};
+
+////////////////////////////////////////////////////////////////////////
+// Frame pacing
+////////////////////////////////////////////////////////////////////////
+struct FramePacing
+{
+    bool has_last_present_time;
+    struct timeval last_present_time;
+    std::deque<long> frame_intervals;       // time between two presented frames (us)
+    std::deque<long> latencies;             // time from input handling to frame completion (us)
+};
+
+////////////////////////////////////////////////////////////////////////
+// Setup phase timer, adds the time spent in its scope to a counter (us)
+////////////////////////////////////////////////////////////////////////
+class ScopedTimer
+{
+public:
+    ScopedTimer(long& io_time);
+    ~ScopedTimer();
+
+private:
+    long& m_time;
+    struct timeval m_start;
+};
+
+////////////////////////////////////////////////////////////////////////
+// Functions
+////////////////////////////////////////////////////////////////////////
+long elapsed_time_us(const struct timeval& in_start, const struct timeval& in_end);
+void print_fixed(std::ostream& out_stream, double in_value, int in_nb_decimals);
+double mean_time(const std::deque<long>& in_times);
+void print_rendering_time (std::ostream& out_stream, unsigned int in_nb_triangles, double in_nb_pixels, const std::deque<long>& in_rendering_times);
+long median_time(const std::deque<long>& in_times);
+double median_relative_precision(const std::deque<long>& in_times);
+SamplingState sampling_state(const std::deque<long>& in_times, unsigned int in_min_frames, unsigned int in_max_frames, double in_target_precision,
+                             long in_elapsed_time, long in_time_budget);
+void print_sampling(std::ostream& out_stream, const std::deque<long>& in_times, SamplingState in_sampling_state);
+void clear_frame_pacing(FramePacing& out_frame_pacing);
+void update_frame_pacing(FramePacing& io_frame_pacing, const struct timeval& in_input_time, const struct timeval& in_present_time);
+void print_frame_pacing(std::ostream& out_stream, const FramePacing& in_frame_pacing);
+void read_process_memory(size_t& out_rss, size_t& out_peak_rss);
+void reset_peak_rss();